@@ -0,0 +1,81 @@
+/*
+  idPushButton adaptive debounce check - runs PBmonitor<LOW> with PB_ADAPTIVE on the simulated hardware of idPBhost.h
+  Feeds bouncing presses of a healthy and of a worn switch, with presses both longer and shorter than the maxMs
+  given to setAdaptive(), and reports the presses registered and the debounce time learned. A press held longer
+  than twice the bouncing of the switch must always be registered - the learned debounce must not turn into a
+  minimum press time. Exits with 1 if any press was missed or reported more than once.
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbAdaptive.cpp -o pbAdaptive && ./pbAdaptive
+
+ created 16.10.2026
+ */
+
+#define PB_ADAPTIVE 1
+#define PB_REGISTRY_SIZE 1 // the button served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+
+#define PRESSES 400
+#define PIN 2
+
+unsigned long calls;
+void Count(unsigned long n) { calls++; }
+
+PBmonitor<LOW> button(PIN, Count); // served by the shared ISR, 20ms initial debounce
+
+struct Scenario
+{
+  const char *name;
+  uint8_t minMs, maxMs; // setAdaptive() bounds
+  uint8_t bounces; // bounce pulses on make and on break
+  unsigned long jitter; // up to .. us between bounce edges
+  unsigned long holdMin, holdMax; // press duration range in ms
+};
+
+const Scenario scenarios[] = {
+  { "healthy, 60ms presses",        5, 100, 3,  300,  60,  60 },
+  { "healthy, 150ms presses",       5, 200, 3,  300, 150, 150 },
+  { "healthy, 30..300ms presses",   2,  40, 3,  300,  30, 300 },
+  { "healthy, 25ms taps",           2, 100, 2,  200,  25,  25 },
+  { "worn, 60..300ms presses",      2, 100, 8, 2000,  60, 300 },
+  { "worn, 80ms presses",           5, 200, 8, 2000,  80,  80 },
+};
+
+bool run(const Scenario &sc)
+{
+  pbSim::reset();
+  button.setUBdelay(20);
+  button.startMonitoring();
+  button.setAdaptive(sc.minMs, sc.maxMs);
+  pbSim::Rng rng(2016);
+  pbSim::Bounce b;
+  b.bounces = sc.bounces;
+  b.jitter = sc.jitter;
+  unsigned long missed = 0, extra = 0;
+  for(unsigned int i = 0; i < PRESSES; i++)
+  {
+    b.hold = rng.uniform(sc.holdMin, sc.holdMax) * 1000UL;
+    calls = 0;
+    unsigned long long settled = pbSim::press(PIN, LOW, pbSim::now() + 1000, b, rng);
+    pbSim::run(settled + rng.uniform(100, 400) * 1000UL); // a pause between the presses
+    if(!calls)
+      missed++;
+    else
+      extra += calls - 1;
+  }
+  button.stopMonitoring();
+  printf("%-28s setAdaptive(%3u,%3u): %3lu of %u registered, %lu false, debounce %3lu ms, estimate %6lu us\n", sc.name,
+    sc.minMs, sc.maxMs, PRESSES - missed, PRESSES, extra, button.getUBdelay(), button.getEstimate());
+  return !missed && !extra;
+}
+
+int main()
+{
+  bool ok = true;
+  for(unsigned int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    ok = run(scenarios[i]) && ok;
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+/*
+  idPushButton atomic backend stress test - runs the PB_ATOMIC build of idPushButton.h with several threads standing
+  in for the cores / tasks of a multicore or RTOS target and checks that no press is lost or reported twice:
+   - the event queue alone: producer threads pushing numbered events, consumer threads popping them
+   - buttons: one producer thread per button toggling its (simulated) pin and calling change() as its ISR would,
+     consumer threads calling poll() on all the buttons, in deferred and in immediate mode
+   - the interrupts: bouncing presses on the simulated pins, served by the ISRs the buttons attached
+  idPBhost.h stands in for a Cortex-M core then - no SREG and no EnableInterrupt library, the buttons attach their
+  ISRs by attachInterrupt() and guard their state by PRIMASK.
+  Reports the throughput and exits with 1 if any event or press was lost or duplicated.
+
+  Build and run (from this directory):
+    g++ -O2 -pthread -DPB_HOST -I../.. pbAtomic.cpp -o pbAtomic && ./pbAtomic [producers [consumers]]
+
+ created 16.10.2026
+ */
+
+#define PB_ATOMIC 1
+#define PB_QUEUE_SIZE 16
+#define PB_REGISTRY_SIZE PB_SIM_PORTS // the buttons (BUTTONS) served by their ISRs
+#include "idPushButton.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define EVENTS 500000UL // pushed by each producer in the queue test
+#define PRESSES 100000UL // per button in the button test
+#define BUTTONS PB_SIM_PORTS // one per simulated port, so the producers do not share a port register
+
+typedef std::chrono::steady_clock Clock;
+double since(Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); }
+
+// producer p pushes the events (p, n) for n = 0..EVENTS-1 in order, every one of them must be popped exactly once
+// and every consumer must see the events of a producer in that order
+bool queueTest(unsigned int producers, unsigned int consumers)
+{
+  static PBeventQueue<PB_QUEUE_SIZE> q;
+  q.clearOverflows();
+  std::vector<std::atomic<uint8_t> > seen(producers * EVENTS);
+  for(size_t i = 0; i < seen.size(); i++)
+    seen[i].store(0);
+  std::atomic<unsigned int> done(0), disorder(0);
+  std::atomic<unsigned long> popped(0);
+  std::vector<std::thread> threads;
+  Clock::time_point t0 = Clock::now();
+  for(unsigned int p = 0; p < producers; p++)
+    threads.push_back(std::thread([&, p]() {
+      for(unsigned long n = 0; n < EVENTS; n++)
+        while(!q.push(p, 0, n)) // full - retry, it is counted as an overflow
+          std::this_thread::yield();
+      done++;
+    }));
+  for(unsigned int c = 0; c < consumers; c++)
+    threads.push_back(std::thread([&]() {
+      std::vector<long> last(producers, -1);
+      unsigned long n = 0;
+      PBevent e;
+      for(;;)
+        if(q.pop(e))
+        {
+          if((long)e.t <= last[e.id])
+            disorder++;
+          last[e.id] = e.t;
+          seen[e.id * EVENTS + e.t]++;
+          n++;
+        }
+        else if(done == producers && !q.pending())
+          break;
+        else // empty - let the producers run (on a single core)
+          std::this_thread::yield();
+      popped += n;
+    }));
+  for(size_t i = 0; i < threads.size(); i++)
+    threads[i].join();
+  double sec = since(t0);
+  unsigned long lost = 0, dup = 0;
+  for(size_t i = 0; i < seen.size(); i++)
+    if(!seen[i])
+      lost++;
+    else if(seen[i] > 1)
+      dup += seen[i] - 1;
+  printf("queue   %u producers %u consumers: %lu events in %.3f s, %.1f M/s, full %u times, lost %lu, duplicated %lu, out of order %u\n",
+    producers, consumers, popped.load(), sec, popped / sec / 1e6, q.getOverflows(), lost, dup, disorder.load());
+  return !lost && !dup && !disorder && popped == producers * EVENTS;
+}
+
+std::atomic<unsigned long> counted[BUTTONS];
+void Pressed(void *ctx, unsigned long n) { (*static_cast<std::atomic<unsigned long> *>(ctx))++; }
+
+// producer b presses button b PRESSES times (an ISR per edge), the consumers poll all the buttons meanwhile
+bool buttonTest(unsigned int consumers, bool deferred)
+{
+  static PBmonitor<LOW> *buttons[BUTTONS];
+  unsigned long overflows = 0;
+  pbSim::reset();
+  for(unsigned int b = 0; b < BUTTONS; b++)
+  {
+    counted[b].store(0);
+    if(!buttons[b])
+      buttons[b] = new PBmonitor<LOW>(b * 8, Pressed, &counted[b], ONPRESS);
+    buttons[b]->setDeferred(deferred);
+    buttons[b]->startMonitoring();
+    overflows -= buttons[b]->getOverflows(); // of the previous runs
+  }
+  std::atomic<unsigned int> done(0);
+  std::vector<std::thread> threads;
+  Clock::time_point t0 = Clock::now();
+  for(unsigned int b = 0; b < BUTTONS; b++)
+    threads.push_back(std::thread([&, b]() {
+      PBmonitor<LOW> &button = *buttons[b];
+      volatile uint32_t &port = pbSim::state().port[b];
+      for(unsigned long n = 0; n < PRESSES; n++)
+        for(int edge = 0; edge < 2; edge++)
+        {
+          while(button.getPending() >= PB_QUEUE_SIZE - 1) // the edges of a real button are far apart
+            std::this_thread::yield();
+          port = edge ? 1 : 0; // pushed (LOW), released (HIGH)
+          button.change();
+        }
+      done++;
+    }));
+  for(unsigned int c = 0; c < consumers; c++)
+    threads.push_back(std::thread([&]() {
+      for(;;)
+      {
+        bool last = done == BUTTONS;
+        for(unsigned int b = 0; b < BUTTONS; b++)
+          buttons[b]->poll();
+        std::this_thread::yield();
+        if(last)
+          break;
+      }
+    }));
+  for(size_t i = 0; i < threads.size(); i++)
+    threads[i].join();
+  for(unsigned int b = 0; b < BUTTONS; b++) // whatever a consumer left behind
+    buttons[b]->poll();
+  double sec = since(t0);
+  bool ok = true;
+  unsigned long total = 0, lost = 0, dup = 0;
+  for(unsigned int b = 0; b < BUTTONS; b++)
+  {
+    unsigned long c = counted[b];
+    total += c;
+    if(c < PRESSES)
+      lost += PRESSES - c;
+    else
+      dup += c - PRESSES;
+    overflows += buttons[b]->getOverflows();
+    ok = ok && c == PRESSES && buttons[b]->isIdle();
+    buttons[b]->stopMonitoring();
+  }
+  printf("buttons %u producers %u consumers, %s: %lu presses in %.3f s, %.1f M/s, overflows %lu, lost %lu, duplicated %lu\n",
+    BUTTONS, consumers, deferred ? "deferred " : "immediate", total, sec, total / sec / 1e6, overflows, lost, dup);
+  return ok && !overflows;
+}
+
+// bouncing presses on the pins of all the buttons (ISRs of the registry entries attached by attachInterrupt())
+bool isrTest(bool deferred)
+{
+  static PBmonitor<LOW> *buttons[BUTTONS];
+  const unsigned long presses = 1000;
+  pbSim::reset();
+  pbSim::Rng rng(7);
+  pbSim::Bounce bounce;
+  bounce.bounces = 3;
+  bounce.jitter = 500;
+  bounce.hold = 100000;
+  for(unsigned int b = 0; b < BUTTONS; b++)
+  {
+    counted[b].store(0);
+    pbSim::setPin(b * 8, HIGH);
+    if(!buttons[b])
+      buttons[b] = new PBmonitor<LOW>(b * 8, Pressed, &counted[b], ONRELEASE); // debounced by the time held
+    buttons[b]->setDeferred(deferred);
+    buttons[b]->startMonitoring();
+  }
+  unsigned long long t = 0;
+  for(unsigned long n = 0; n < presses; n++)
+  {
+    for(unsigned int b = 0; b < BUTTONS; b++) // the buttons pushed at once, so their ISRs interleave
+      pbSim::press(b * 8, LOW, t + b * 100, bounce, rng);
+    for(unsigned long long end = t + 200000; pbSim::now() < end; )
+    {
+      pbSim::advance(1000);
+      for(unsigned int b = 0; b < BUTTONS; b++)
+        buttons[b]->poll();
+    }
+    t = pbSim::now();
+  }
+  bool ok = true;
+  unsigned long total = 0;
+  for(unsigned int b = 0; b < BUTTONS; b++)
+  {
+    total += counted[b];
+    ok = ok && counted[b] == presses && buttons[b]->isIdle();
+    buttons[b]->stopMonitoring();
+  }
+  printf("ISRs    %u buttons, %s: %lu of %lu presses, %lu ISR calls\n", BUTTONS, deferred ? "deferred " : "immediate",
+    total, BUTTONS * presses, pbSim::state().isrCalls);
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned int producers = argc > 1 ? atoi(argv[1]) : 4;
+  unsigned int consumers = argc > 2 ? atoi(argv[2]) : 4;
+  if(producers < 1 || producers > 255 || consumers < 1)
+  {
+    fprintf(stderr, "usage: %s [producers (1..255) [consumers]]\n", argv[0]);
+    return 2;
+  }
+  bool ok = queueTest(producers, consumers);
+  ok = queueTest(1, 1) && ok;
+  ok = buttonTest(consumers, true) && ok;
+  ok = buttonTest(consumers, false) && ok;
+  ok = buttonTest(1, true) && ok;
+  ok = isrTest(false) && ok;
+  ok = isrTest(true) && ok;
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
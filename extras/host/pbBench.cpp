@@ -0,0 +1,159 @@
+/*
+  idPushButton host benchmark - runs PBmonitor<LOW> and PBmonitor<HIGH> on the simulated hardware of idPBhost.h
+  Feeds deterministic bouncing presses (with different bounce counts) to the buttons and reports
+  the edges processed per second (of real CPU time) and the number of missed and false presses
+  for the immediate (in the ISR) and the deferred (poll() from loop) dispatch, and for the leading edge mode
+  (ONPRESS, reacting on the first edge) with the latency from the first edge to the callback.
+  The leading edge mode is also fed taps released within the lockout, each followed by a press soon after the
+  lockout - with and without loop() calling expire(). Exits with 1 if one of these presses is missed, reported
+  twice or later than a millisecond.
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbBench.cpp -o pbBench && ./pbBench
+
+ created 16.10.2026
+ */
+
+#define PB_QUEUE_SIZE 16
+#define PB_LEADING 1 // the leading edge mode is compared too
+#define PB_REGISTRY_SIZE 2 // the leading edge buttons served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+#include <chrono>
+
+#define PRESSES 20000
+#define PIN_L 2
+#define PIN_H 3
+
+unsigned long calls;
+unsigned long long firstCall, lastCall; // time of the first and of the last callback of a press
+void Count(unsigned long n) { if(!calls++) firstCall = pbSim::now(); lastCall = pbSim::now(); }
+
+void IsrL();
+void IsrH();
+PBmonitor<LOW> buttonL(PIN_L, Count, IsrL, ONRELEASE, 20);
+PBmonitor<HIGH> buttonH(PIN_H, Count, IsrH, ONRELEASE, 20);
+void IsrL() { buttonL.change(); }
+void IsrH() { buttonH.change(); }
+PBmonitor<LOW> leadingL(PIN_L, Count, ONPRESS); // served by the shared ISR
+PBmonitor<HIGH> leadingH(PIN_H, Count, ONPRESS);
+
+#define DEFERRED 1
+#define LEADING 2
+const char *modes[] = { "immediate", "deferred", "leading" };
+
+template <class PB>
+void bench(PB &button, uint8_t pin, const char *name, uint8_t mode, uint8_t bounces)
+{
+  pbSim::reset();
+  bool deferred = mode == DEFERRED;
+  button.setDeferred(deferred);
+  button.setLeadingEdge(mode == LEADING ? 20000 : 0); // 20ms lockout
+  button.startMonitoring();
+  pbSim::Rng rng(12345);
+  pbSim::Bounce b;
+  b.bounces = bounces;
+  b.jitter = 500; // up to 0.5ms between bounce edges
+  unsigned long missed = 0, extra = 0;
+  unsigned long long latency = 0; // the longest from the first edge of a press to the callback
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for(unsigned long i = 0; i < PRESSES; i++)
+  {
+    b.hold = rng.uniform(30, 300) * 1000UL; // 30..300ms presses
+    calls = 0;
+    unsigned long long start = pbSim::now() + 1000;
+    unsigned long long settled = pbSim::press(pin, button.type(), start, b, rng);
+    unsigned long long end = settled + 50000; // 50ms pause between presses
+    while(pbSim::now() < end) // the loop() calling poll() every millisecond
+    {
+      pbSim::advance(1000);
+      if(deferred)
+        button.poll();
+    }
+    if(calls == 0)
+      missed++;
+    else
+    {
+      extra += calls - 1;
+      if(firstCall - start > latency)
+        latency = firstCall - start;
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  button.stopMonitoring();
+
+  printf("%-16s %-9s %7u %10lu %12.0f %8lu %8lu %9u %11llu\n", name, modes[mode], bounces,
+    pbSim::state().edges, pbSim::state().edges / sec, missed, extra, button.getOverflows(), latency);
+}
+
+// a tap released within the lockout, then a press after it - the release missed must not start another lockout
+template <class PB>
+bool taps(PB &button, uint8_t pin, const char *name, bool expiring)
+{
+  pbSim::reset();
+  button.setLeadingEdge(20000); // 20ms lockout
+  button.startMonitoring();
+  pbSim::Rng rng(12345);
+  pbSim::Bounce b;
+  b.jitter = 300;
+  unsigned long missed = 0, extra = 0;
+  unsigned long long latency = 0; // the longest from the first edge of the press to its callback
+  for(unsigned long i = 0; i < PRESSES / 10; i++)
+  {
+    calls = 0;
+    unsigned long long tap = pbSim::now() + 1000;
+    b.bounces = rng.uniform(0, 2);
+    b.hold = rng.uniform(3, 10) * 1000UL; // released within the lockout
+    pbSim::press(pin, button.type(), tap, b, rng);
+    unsigned long long start = tap + rng.uniform(21, 40) * 1000UL; // pushed again after the lockout
+    b.hold = rng.uniform(30, 100) * 1000UL;
+    unsigned long long end = pbSim::press(pin, button.type(), start, b, rng) + 50000;
+    while(pbSim::now() < end) // the loop() calling expire() every millisecond
+    {
+      pbSim::advance(1000);
+      if(expiring)
+        button.expire();
+    }
+    if(calls < 2)
+      missed += 2 - calls;
+    else
+    {
+      extra += calls - 2;
+      if(lastCall - start > latency)
+        latency = lastCall - start;
+    }
+  }
+  button.stopMonitoring();
+  printf("%-16s %-9s %-19s %8lu %8lu %11llu\n", name, "leading", expiring ? "taps, expire()" : "taps", missed, extra,
+    latency);
+  return !missed && !extra && latency <= 1000;
+}
+
+int main()
+{
+  printf("%d presses per run, 30..300ms hold, bounce edges up to 0.5ms apart, 20ms debounce (lockout)\n\n", PRESSES);
+  printf("%-16s %-9s %7s %10s %12s %8s %8s %9s %11s\n", "button", "dispatch", "bounces", "edges", "edges/s", "missed", "false", "overflows", "latency(us)");
+  const uint8_t bounces[] = { 0, 2, 5, 10 };
+  for(uint8_t m = 0; m < 2; m++)
+    for(uint8_t i = 0; i < sizeof(bounces); i++)
+    {
+      bench(buttonL, PIN_L, "PBmonitor<LOW>", m, bounces[i]);
+      bench(buttonH, PIN_H, "PBmonitor<HIGH>", m, bounces[i]);
+    }
+  for(uint8_t i = 0; i < sizeof(bounces); i++)
+  {
+    bench(leadingL, PIN_L, "PBmonitor<LOW>", LEADING, bounces[i]);
+    bench(leadingH, PIN_H, "PBmonitor<HIGH>", LEADING, bounces[i]);
+  }
+  printf("\n%-16s %-9s %-19s %8s %8s %11s\n", "button", "dispatch", "presses", "missed", "false", "latency(us)");
+  bool ok = true;
+  for(uint8_t expiring = 0; expiring < 2; expiring++)
+  {
+    ok = taps(leadingL, PIN_L, "PBmonitor<LOW>", expiring) && ok;
+    ok = taps(leadingH, PIN_H, "PBmonitor<HIGH>", expiring) && ok;
+  }
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+/*
+  idPushButton chords check - runs two PBmonitor<LOW> joined to a PBchords on the simulated hardware of idPBhost.h
+  Every round one button glitches (pushed shorter than the debounce time) and then both buttons are pushed together,
+  or one of them alone, with bouncing contacts. The glitch must not leave the button in chords.pressed() nor join it
+  to a chord, so the real chord that follows is reported as the chord and the single press as the single button.
+  Exits with 1 on any chord or press missed or reported wrongly, or if pressed() is not 0 once all are released.
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbChords.cpp -o pbChords && ./pbChords
+
+ created 16.10.2026
+ */
+
+#define PB_CHORDS_SIZE 1
+#define PB_REGISTRY_SIZE 2 // the buttons served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+
+#define ROUNDS 1000
+#define PIN1 2
+#define PIN2 3
+#define BTN1 (1 << 0)
+#define BTN2 (1 << 1)
+
+unsigned long calls1, calls2, chordCalls, wrongChords;
+void Count1(unsigned long n) { calls1++; }
+void Count2(unsigned long n) { calls2++; }
+void OnChord(uint8_t chord, unsigned long held)
+{
+  if(chord == (BTN1 | BTN2))
+    chordCalls++;
+  else
+    wrongChords++;
+}
+
+PBmonitor<LOW> button1(PIN1, Count1); // served by the shared ISR, on release, 20ms debounce
+PBmonitor<LOW> button2(PIN2, Count2);
+PBchords chords(OnChord, 50);
+
+int main()
+{
+  pbSim::reset();
+  pbSim::setPin(PIN1, HIGH);
+  pbSim::setPin(PIN2, HIGH);
+  chords.add(BTN1 | BTN2);
+  button1.setChords(&chords, 0);
+  button2.setChords(&chords, 1);
+  button1.startMonitoring();
+  button2.startMonitoring();
+  pbSim::Rng rng(2016);
+  pbSim::Bounce b;
+  b.jitter = 300;
+  unsigned long expCalls1 = 0, expCalls2 = 0, expChords = 0, stuck = 0;
+  for(unsigned int r = 0; r < ROUNDS; r++)
+  {
+    uint8_t glitched = rng.uniform(0, 1) ? PIN1 : PIN2;
+    unsigned long long t = pbSim::now() + 1000;
+    pbSim::schedule(t, glitched, LOW); // a glitch, shorter than the debounce time
+    pbSim::schedule(t + rng.uniform(1, 10) * 1000UL, glitched, HIGH);
+    pbSim::run(t + rng.uniform(50, 200) * 1000UL); // well after the chord window and the debounce time
+    if(chords.pressed())
+      stuck++;
+    t = pbSim::now();
+    uint8_t kind = rng.uniform(0, 2); // both, button 1 alone, button 2 alone
+    b.bounces = rng.uniform(0, 3);
+    b.hold = rng.uniform(100, 300) * 1000UL;
+    unsigned long long end = kind != 2 ? pbSim::press(PIN1, LOW, t, b, rng) : t;
+    if(kind != 1) // the second one within the window
+    {
+      b.bounces = rng.uniform(0, 3);
+      b.hold = rng.uniform(100, 300) * 1000UL;
+      unsigned long long e = pbSim::press(PIN2, LOW, t + (kind ? 0 : rng.uniform(1, 40) * 1000UL), b, rng);
+      if(e > end)
+        end = e;
+    }
+    pbSim::run(end + 100000UL);
+    expChords += kind == 0;
+    expCalls1 += kind == 1;
+    expCalls2 += kind == 2;
+    if(chords.pressed())
+      stuck++;
+  }
+  bool ok = calls1 == expCalls1 && calls2 == expCalls2 && chordCalls == expChords && !wrongChords && !stuck;
+  printf("%u rounds: chords %lu of %lu, singles %lu of %lu and %lu of %lu, wrong chords %lu, pressed() left set %lu\n",
+    ROUNDS, chordCalls, expChords, calls1, expCalls1, calls2, expCalls2, wrongChords, stuck);
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/*
+  idPushButton host encoder benchmark - runs PBencoder on the simulated hardware of idPBhost.h
+  Turns a simulated quadrature encoder back and forth (the edges with a random jitter of +-25%) and finds the highest
+  edge rate decoded without losing a step, for a few times taken by the ISR (on the target it depends on the CPU
+  and on the ISR used - own or the shared one of PBregistry, measure it e.g. with idPBBenchISR).
+  Also reports the edges decoded per second of real CPU time.
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbEncoder.cpp -o pbEncoder && ./pbEncoder
+
+ created 16.10.2026
+ */
+
+#define PB_REGISTRY_SIZE 2 // the encoder pins served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+#include <chrono>
+
+#define PIN_A 2
+#define PIN_B 3
+#define STEPS 2000 // steps (4 edges each) per run, half forward, half back
+
+PBencoder encoder(PIN_A, PIN_B, 4); // served by the shared ISR
+
+// turns the encoder by steps (negative - back) with edges period us apart, returns the time of the last edge
+unsigned long long turn(long steps, unsigned long period, unsigned long long t, pbSim::Rng &rng)
+{
+  static const uint8_t gray[4] = { 0, 1, 3, 2 }; // AB states counting up
+  static uint8_t phase = 0;
+  for(long i = 0; i < 4 * (steps < 0 ? -steps : steps); i++)
+  {
+    uint8_t prev = gray[phase];
+    phase = (phase + (steps < 0 ? 3 : 1)) & 3;
+    t += period - period / 4 + rng.uniform(0, period / 2); // +-25%
+    uint8_t ab = gray[phase];
+    if((ab ^ prev) & 2) // only one of them changes
+      pbSim::schedule(t, PIN_A, ab & 2);
+    else
+      pbSim::schedule(t, PIN_B, ab & 1);
+    if(pbSim::state().queued > PB_SIM_EDGES / 2)
+      pbSim::run(t);
+  }
+  return t;
+}
+
+// true if STEPS forward and back at the edge period (us) end where they started with no invalid transition
+bool lossless(unsigned long period, unsigned long isrTime)
+{
+  pbSim::reset();
+  pbSim::state().isrTime = isrTime;
+  pbSim::setPin(PIN_A, LOW); // AB = 00 (phase 0)
+  pbSim::setPin(PIN_B, LOW);
+  encoder.setPosition(0);
+  encoder.startMonitoring();
+  unsigned int errors = encoder.getErrors();
+  pbSim::Rng rng(4242);
+  unsigned long long t = turn(STEPS / 2, period, 1000, rng);
+  pbSim::run(t + 1000);
+  bool ok = encoder.getPosition() == STEPS / 2;
+  t = turn(-STEPS / 2, period, t + 1000, rng);
+  pbSim::run(t + 1000);
+  ok = ok && encoder.getPosition() == 0 && encoder.getErrors() == errors;
+  encoder.stopMonitoring();
+  return ok;
+}
+
+int main()
+{
+  printf("%d steps forward and back, edges jittered +-25%%\n\n", STEPS);
+  printf("%12s %20s %22s\n", "ISR time(us)", "min edge period(us)", "max edges/s lossless");
+  const unsigned long isrTimes[] = { 2, 4, 8, 16, 32 };
+  for(uint8_t i = 0; i < sizeof(isrTimes) / sizeof(isrTimes[0]); i++)
+  {
+    unsigned long lo = 1, hi = 1000; // hi is lossless, find the shortest period that is
+    while(lo < hi)
+    {
+      unsigned long mid = (lo + hi) / 2;
+      if(lossless(mid, isrTimes[i]))
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    printf("%12lu %20lu %22.0f\n", isrTimes[i], hi, 1e6 / hi);
+  }
+
+  pbSim::reset(); // decoding throughput on this CPU (the ISRs taking no virtual time)
+  pbSim::setPin(PIN_A, LOW);
+  pbSim::setPin(PIN_B, LOW);
+  encoder.setPosition(0);
+  encoder.startMonitoring();
+  unsigned int errors = encoder.getErrors();
+  pbSim::Rng rng(1);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  unsigned long long t = 1000;
+  for(int r = 0; r < 100; r++)
+    t = turn(r & 1 ? -STEPS : STEPS, 100, t, rng);
+  pbSim::run(t + 1000);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("\n%lu edges decoded in %.3f s, %.0f edges/s, position %ld, errors %u\n", pbSim::state().edges, sec,
+    pbSim::state().edges / sec, encoder.getPosition(), encoder.getErrors() - errors);
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*
+  idPushButton key matrix check - runs PBmatrix<4, 4> on the simulated hardware of idPBhost.h
+  The keys are modeled by the circuit hook of the simulator (pbSim::state().circuit): a column reads LOW while a key
+  pushed connects it to a row driven LOW (a diode in series with every key, so no ghosting), else its pullup keeps it
+  HIGH. Every round pushes a random set of keys, with chatter, at once or one after the other, holds them down
+  together and releases them; loop() calls poll() every millisecond. Every key pushed must be reported exactly once,
+  with the time it was held, and none other, and once all are released the matrix must go back to waiting for the
+  interrupt - no more scanning until the next key touched raises it. Exits with 1 otherwise.
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbMatrix.cpp -o pbMatrix && ./pbMatrix
+
+ created 16.10.2026
+ */
+
+#define PB_REGISTRY_SIZE 4 // the columns served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+
+#define ROUNDS 1000
+#define ROWS 4
+#define COLS 4
+#define KEYS (ROWS * COLS)
+
+const uint8_t rows[ROWS] = { 8, 9, 10, 11 };
+const uint8_t cols[COLS] = { 16, 17, 18, 19 }; // all on one port
+
+bool down[KEYS]; // the keys pushed (the contacts closed)
+unsigned long calls[KEYS], held[KEYS];
+unsigned long updates; // of the circuit - after every pinMode() / digitalWrite() of PBmatrix
+
+void OnKey(uint8_t key, unsigned long t)
+{
+  calls[key]++;
+  held[key] = t;
+}
+
+PBmatrix<ROWS, COLS> keypad(rows, cols, OnKey); // on release, 2ms scan period
+
+void Circuit() // the levels of the columns for the rows driven and the keys pushed
+{
+  pbSim::State &s = pbSim::state();
+  updates++;
+  for(uint8_t c = 0; c < COLS; c++)
+  {
+    bool low = false;
+    for(uint8_t r = 0; r < ROWS; r++)
+      low |= down[r * COLS + c] && s.mode[rows[r]] == OUTPUT; // PBmatrix drives the rows LOW only
+    pbSim::setPin(cols[c], !low);
+  }
+}
+
+void setKey(uint8_t key, bool pushed, pbSim::Rng &rng) // with a few chatter pulses
+{
+  for(uint8_t i = rng.uniform(0, 3); i > 0; i--)
+  {
+    down[key] = pushed;
+    Circuit();
+    pbSim::advance(rng.uniform(50, 300));
+    down[key] = !pushed;
+    Circuit();
+    pbSim::advance(rng.uniform(50, 300));
+  }
+  down[key] = pushed;
+  Circuit();
+}
+
+void loopFor(unsigned long ms) // loop() calling poll() every millisecond
+{
+  for(unsigned long i = 0; i < ms; i++)
+  {
+    pbSim::advance(1000);
+    keypad.poll();
+  }
+}
+
+int main()
+{
+  pbSim::reset();
+  pbSim::state().circuit = Circuit;
+  if(!keypad.startMonitoring())
+  {
+    printf("FAIL - not started\n");
+    return 1;
+  }
+  loopFor(20); // the first scan finds nothing pushed
+  pbSim::Rng rng(2016);
+  unsigned long presses = 0, rollover = 0, missed = 0, extra = 0, wrongTime = 0, notHeld = 0, busy = 0, idleScans = 0;
+  unsigned long notWoken = 0;
+  for(unsigned int r = 0; r < ROUNDS; r++)
+  {
+    uint16_t set; // the keys pushed together - 1 up to all of them (n-key rollover)
+    do
+      set = rng.next() & rng.next() & ((1UL << KEYS) - 1);
+    while(!set);
+    unsigned long long pushedAt[KEYS];
+    for(uint8_t k = 0; k < KEYS; k++)
+    {
+      calls[k] = 0;
+      if(set & (1 << k))
+      {
+        setKey(k, true, rng);
+        pushedAt[k] = pbSim::now();
+        if(!keypad.isScanning()) // the first key touched wakes it by the interrupt of its column
+          notWoken++;
+        loopFor(rng.uniform(0, 5));
+      }
+    }
+    loopFor(rng.uniform(30, 100));
+    for(uint8_t k = 0; k < KEYS; k++)
+      if((set & (1 << k)) && !keypad.isPressed(k))
+        notHeld++;
+    unsigned long long releasedAt[KEYS];
+    for(uint8_t k = 0; k < KEYS; k++)
+      if(set & (1 << k))
+      {
+        setKey(k, false, rng);
+        releasedAt[k] = pbSim::now();
+        loopFor(rng.uniform(0, 5));
+      }
+    loopFor(50); // all settled
+    uint8_t n = 0;
+    for(uint8_t k = 0; k < KEYS; k++)
+    {
+      if(!(set & (1 << k)))
+      {
+        extra += calls[k];
+        continue;
+      }
+      n++;
+      if(!calls[k])
+        missed++;
+      else
+      {
+        extra += calls[k] - 1;
+        long d = (long)held[k] - (long)((releasedAt[k] - pushedAt[k]) / 1000);
+        if(d < -(long)keypad.getUBdelay() || d > (long)keypad.getUBdelay()) // within a debounce time
+          wrongTime++;
+      }
+    }
+    presses += n;
+    rollover += n > 1;
+    if(keypad.isScanning())
+      busy++;
+    unsigned long u = updates;
+    loopFor(20); // idle - poll() must not scan (drive the rows) any more
+    idleScans += updates != u;
+  }
+  keypad.stopMonitoring();
+  bool ok = !missed && !extra && !wrongTime && !notHeld && !busy && !idleScans && !notWoken;
+  printf("%u rounds, %lu presses (%lu rounds with 2 or more keys down): missed %lu, false %lu, time held off %lu, "
+    "not held %lu, not woken %lu, still scanning %lu, scanning while idle %lu\n", ROUNDS, presses, rollover, missed,
+    extra, wrongTime, notHeld, notWoken, busy, idleScans);
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
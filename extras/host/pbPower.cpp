@@ -0,0 +1,69 @@
+/*
+  idPushButton host duty cycle report - runs a button served by the shared ISR with loop() calling PBpower::sleep()
+  on the simulated hardware of idPBhost.h and reports the fraction of the time the MCU is powered down, sleeping
+  in idle mode (while a button is pushed) and awake, for several press rates, with and without the watchdog
+  keeping millis() going. Every wake is taken to keep the MCU awake for WAKE_US (the ISR and a pass of loop()).
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbPower.cpp -o pbPower && ./pbPower
+
+ created 16.10.2026
+ */
+
+#define PB_REGISTRY_SIZE 1 // the button served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+
+#define PIN 2
+#define HOURS 1 // simulated time per run
+#define WAKE_US 50 // time awake on every wake up
+
+unsigned long presses;
+void Pressed(unsigned long n) { presses++; }
+
+PBmonitor<LOW> button(PIN, Pressed); // served by the shared ISR
+
+void run(unsigned int perMinute, int8_t wdto)
+{
+  pbSim::reset();
+  PBpower::setWatchdog(wdto);
+  button.startMonitoring();
+  presses = 0;
+  pbSim::Rng rng(perMinute);
+  pbSim::Bounce b;
+  b.bounces = 3;
+  b.jitter = 500;
+  unsigned long long end = HOURS * 3600000000ULL, awake = 0;
+  unsigned long pushed = 0;
+  while(pbSim::now() < end)
+  {
+    if(!pbSim::state().queued) // the previous press is over - the next one at a random time (mean 60 / perMinute s)
+    {
+      b.hold = rng.uniform(80, 300) * 1000UL;
+      pbSim::press(PIN, LOW, pbSim::now() + rng.uniform(1, 120000000UL / perMinute), b, rng);
+      pushed++;
+    }
+    if(PBpower::sleep() == PB_AWAKE)
+      pbSim::advance(1000);
+    pbSim::advance(WAKE_US); // the ISRs and loop() after the wake up
+    awake += WAKE_US;
+  }
+  button.stopMonitoring();
+  pbSim::State &s = pbSim::state();
+  double total = (double)s.now;
+  printf("%10u %9s %11.4f%% %9.4f%% %9.4f%% %10.1f %8lu/%lu\n", perMinute, wdto < 0 ? "off" : wdto == WDTO_1S ? "1s" : "?",
+    100.0 * s.sleptDeep / total, 100.0 * s.sleptIdle / total, 100.0 * awake / total, s.wakeups / (total / 1e6),
+    presses, pushed);
+}
+
+int main()
+{
+  printf("%d h simulated per run, %dus awake per wake up, 80..300ms presses\n\n", HOURS, WAKE_US);
+  printf("%10s %9s %12s %10s %10s %10s %10s\n", "presses/m", "watchdog", "power down", "idle", "awake", "wakeups/s", "presses");
+  const unsigned int rates[] = { 1, 6, 60, 600 };
+  for(uint8_t w = 0; w < 2; w++)
+    for(uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+      run(rates[i], w ? WDTO_1S : -1);
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*
+  idPushButton deferred mode stress test - runs PBmonitor<LOW> in deferred mode on the simulated hardware of idPBhost.h
+  with loop() calling poll() only after bursts of presses, as it would while busy with something else. Up to
+  PB_QUEUE_SIZE edges between two polls (the supported rate) no press may be lost; beyond it exactly the edges that
+  did not fit the queue must be counted by getOverflows() and the presses that did fit still registered.
+  Exits with 1 on any lost or extra press or on an overflow count off by any edge.
+
+  Build and run (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbQueue.cpp -o pbQueue && ./pbQueue
+
+ created 16.10.2026
+ */
+
+#define PB_QUEUE_SIZE 8
+#define PB_REGISTRY_SIZE 1 // the button served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+
+#define ROUNDS 1000 // bursts (polls) per scenario
+#define PIN 2
+
+unsigned long calls;
+void Count(unsigned long n) { calls++; }
+
+PBmonitor<LOW> button(PIN, Count); // served by the shared ISR, on release, 20ms debounce
+
+struct Scenario
+{
+  const char *name;
+  uint8_t pressesMin, pressesMax; // presses between two polls
+  uint8_t bounces; // up to .. bounce pulses on make and on break (kept within PB_QUEUE_SIZE edges)
+};
+
+const Scenario scenarios[] = {
+  { "supported, bouncing",       1, PB_QUEUE_SIZE / 2,     1 },
+  { "supported, clean",          1, PB_QUEUE_SIZE / 2,     0 },
+  { "beyond, clean",             PB_QUEUE_SIZE / 2 + 1, 2 * PB_QUEUE_SIZE, 0 },
+  { "mixed, clean",              1, PB_QUEUE_SIZE,         0 },
+};
+
+bool run(const Scenario &sc)
+{
+  pbSim::reset();
+  pbSim::setPin(PIN, HIGH);
+  button.setDeferred(true);
+  button.startMonitoring();
+  pbSim::Rng rng(2016);
+  pbSim::Bounce b;
+  b.jitter = 300;
+  unsigned long expCalls = 0, expOverflows = 0, edges = 0, maxBurst = 0;
+  unsigned int overflows0 = button.getOverflows(); // of the previous scenarios
+  calls = 0;
+  for(unsigned int r = 0; r < ROUNDS; r++)
+  {
+    uint8_t presses, bounces[2 * PB_QUEUE_SIZE];
+    unsigned int burst;
+    do // a burst - with bounces only as many presses as fit the queue
+    {
+      presses = rng.uniform(sc.pressesMin, sc.pressesMax);
+      burst = 0;
+      for(uint8_t i = 0; i < presses; i++)
+      {
+        bounces[i] = rng.uniform(0, sc.bounces);
+        burst += 2 * (1 + 2 * bounces[i]);
+      }
+    } while(sc.bounces && burst > PB_QUEUE_SIZE);
+    unsigned long long t = pbSim::now() + 1000;
+    for(uint8_t i = 0; i < presses; i++)
+    {
+      b.bounces = bounces[i];
+      b.hold = rng.uniform(25, 60) * 1000UL;
+      t = pbSim::press(PIN, LOW, t, b, rng) + rng.uniform(5, 20) * 1000UL;
+    }
+    pbSim::run(t); // loop() busy meanwhile ...
+    button.poll(); // ... then polls once
+    // the queue keeps the first PB_QUEUE_SIZE edges of the burst - whole presses, as the clean ones have 2 edges
+    expCalls += burst <= PB_QUEUE_SIZE ? presses : PB_QUEUE_SIZE / 2;
+    expOverflows += burst > PB_QUEUE_SIZE ? burst - PB_QUEUE_SIZE : 0;
+    edges += burst;
+    if(burst > maxBurst)
+      maxBurst = burst;
+    if(button.getPending() || !button.isIdle())
+    {
+      printf("%s: round %u - %u edges left in the queue\n", sc.name, r, button.getPending());
+      return false;
+    }
+  }
+  button.stopMonitoring();
+  unsigned long overflows = button.getOverflows() - overflows0;
+  printf("%-22s %6lu edges, up to %2lu per poll: %5lu of %5lu presses registered, overflows %5lu of %5lu\n", sc.name,
+    edges, maxBurst, calls, expCalls, overflows, expOverflows);
+  return calls == expCalls && overflows == expOverflows;
+}
+
+int main()
+{
+  bool ok = true;
+  for(unsigned int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    ok = run(scenarios[i]) && ok;
+  printf(ok ? "PASS\n" : "FAIL\n");
+  return ok ? 0 : 1;
+}
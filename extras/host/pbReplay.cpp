@@ -0,0 +1,161 @@
+/*
+  idPushButton trace replayer - feeds an edge trace captured by PBtrace (binary dump, see idPushButton.h)
+  back through PBmonitor on the simulated hardware of idPBhost.h
+  Prints every press registered (time and duration) so the output of a trace can be kept and compared
+  as a regression test, and replays the trace repeatedly to report the edges processed per second.
+
+  Build (from this directory):
+    g++ -O2 -DPB_HOST -I../.. pbReplay.cpp -o pbReplay
+  Run:
+    ./pbReplay trace.bin [repeat [debounce]]   replay a trace (captured with PBtrace::dump() from Serial)
+    ./pbReplay -g trace.bin                     generate a sample trace of simulated bouncing presses
+
+ created 16.10.2026
+ */
+
+#define PB_TRACE_SIZE 255
+#define PB_REGISTRY_SIZE 2 // the buttons served by the shared ISR
+#include "idPushButton.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+class FilePrint : public Print // Print to a file
+{
+  public:
+    FilePrint(FILE *file) : f(file) { }
+    size_t write(uint8_t c) { return fputc(c, f) == EOF ? 0 : 1; }
+    using Print::write;
+  private:
+    FILE *f;
+};
+
+bool quiet; // do not list the presses (benchmark runs)
+unsigned long presses;
+void Pressed(unsigned long n)
+{
+  presses++;
+  if(!quiet)
+    printf("%10lu ms  press %lu ms\n", millis(), n);
+}
+
+// generates a sample trace: bouncing presses of an active low button on pin 2 captured by PBtrace
+int generate(const char *name)
+{
+  PBtrace trace;
+  PBmonitor<LOW> button(2, Pressed);
+  pbSim::reset();
+  button.startMonitoring();
+  button.setTrace(&trace);
+  pbSim::Rng rng(2016);
+  pbSim::Bounce b;
+  unsigned long long t = 10000;
+  quiet = true;
+  for(int i = 0; i < 10; i++)
+  {
+    b.bounces = rng.uniform(0, 6);
+    b.jitter = 800;
+    b.hold = rng.uniform(10, 600) * 1000UL; // some shorter than the debounce time
+    t = pbSim::press(2, LOW, t + rng.uniform(50, 2000) * 1000UL, b, rng);
+    pbSim::run(t);
+  }
+  FILE *f = fopen(name, "wb");
+  if(!f)
+  {
+    perror(name);
+    return 1;
+  }
+  FilePrint out(f);
+  trace.dump(out);
+  fclose(f);
+  printf("%s: %u edges, %lu presses registered while capturing\n", name, trace.size(), presses);
+  return 0;
+}
+
+template <class PB>
+unsigned long replay(PB &button, uint8_t pin, const uint16_t *words, unsigned int n, unsigned int repeat)
+{
+  unsigned long edges = 0;
+  pbSim::reset();
+  bool first;
+  unsigned long us;
+  PBtrace::decode(words[0], us, first);
+  pbSim::setPin(pin, !first); // the level before the first edge
+  button.startMonitoring();
+  unsigned long long t = pbSim::now() + 1000;
+  for(unsigned int r = 0; r < repeat; r++)
+    for(unsigned int i = 0; i < n; i++)
+    {
+      bool level;
+      PBtrace::decode(words[i], us, level);
+      t += (i || r) ? us : 0;
+      if(!pbSim::schedule(t, pin, level)) // queue full - play back what is scheduled
+      {
+        pbSim::run(pbSim::state().queue[pbSim::state().queued - 1].t);
+        pbSim::schedule(t, pin, level);
+      }
+      edges++;
+    }
+  pbSim::run(t + 1000000);
+  button.stopMonitoring();
+  return edges;
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s trace.bin [repeat [debounce]] | -g trace.bin\n", argv[0]);
+    return 2;
+  }
+  if(!strcmp(argv[1], "-g"))
+    return argc > 2 ? generate(argv[2]) : 2;
+
+  FILE *f = fopen(argv[1], "rb");
+  if(!f)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  uint8_t h[10];
+  static uint16_t words[65536];
+  if(fread(h, 1, sizeof(h), f) != sizeof(h) || memcmp(h, "PBTR", 4) || h[4] != PBtrace::VERSION)
+  {
+    fprintf(stderr, "%s: not a PBtrace dump (version %d)\n", argv[1], PBtrace::VERSION);
+    return 1;
+  }
+  uint8_t pin = h[5];
+  bool type = h[6];
+  unsigned int n = h[8] | h[9] << 8;
+  for(unsigned int i = 0; i < n; i++)
+  {
+    uint8_t w[2];
+    if(fread(w, 1, 2, f) != 2)
+    {
+      fprintf(stderr, "%s: truncated\n", argv[1]);
+      return 1;
+    }
+    words[i] = w[0] | w[1] << 8;
+  }
+  fclose(f);
+  if(!n)
+    return 0;
+  unsigned int repeat = argc > 2 ? atoi(argv[2]) : 1000;
+  unsigned long debounce = argc > 3 ? atol(argv[3]) : 20;
+  pin %= NUM_DIGITAL_PINS;
+  printf("%s: pin %d, active %s, %u edges, debounce %lu ms\n", argv[1], pin, type ? "HIGH" : "LOW", n, debounce);
+
+  PBmonitor<LOW> buttonL(pin, Pressed, ONRELEASE, debounce);
+  PBmonitor<HIGH> buttonH(pin, Pressed, ONRELEASE, debounce);
+  type ? replay(buttonH, pin, words, n, 1) : replay(buttonL, pin, words, n, 1); // the regression output
+  printf("%lu presses\n", presses);
+
+  quiet = true;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  unsigned long edges = type ? replay(buttonH, pin, words, n, repeat) : replay(buttonL, pin, words, n, repeat);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  printf("replayed %u times: %lu edges in %.3f s, %.0f edges/s\n", repeat, edges, sec, edges / sec);
+  return 0;
+}
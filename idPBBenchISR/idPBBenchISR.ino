@@ -0,0 +1,71 @@
+/*
+  idPushButton ISR benchmark - measures the CPU cycles spent sampling the pin inside change()
+  Compares the old way of reading the pin (digitalRead) with the cached port register / bitmask read
+  now used by change(), and times the whole change() call (as invoked from the interrupt)
+  Cycles are counted with Timer1 running at the CPU clock (no prescaler), so AVR boards only (Uno, Nano, Mega...)
+
+  The example circuit:
+   * switch (normally open) from pin 3 to GND (internal pull-up configured), not pressed during the test
+
+ created 16.10.2026
+ */
+
+#include <idPushButton.h>
+
+#define PB1 3
+#define RUNS 1000
+
+void Dummy(unsigned long n) { }
+
+PUSH_BUTTON_L(button1, PB1, Dummy, ONRELEASE);
+
+volatile uint8_t sink; // keeps the compiler from optimizing the reads away
+volatile uint8_t *reg;
+uint8_t mask;
+
+// cycles of the shortest of RUNS runs (the shortest is the one not disturbed by the timer0 interrupt)
+#define MEASURE(RES, CODE) { \
+  RES = 0xFFFF; \
+  for(int r=0; r<RUNS; r++) { \
+    uint8_t oldSREG = SREG; noInterrupts(); \
+    uint16_t t0 = TCNT1; CODE; uint16_t t1 = TCNT1; \
+    SREG = oldSREG; \
+    if((uint16_t)(t1 - t0) < RES) RES = t1 - t0; } }
+
+void report(const char *what, uint16_t cycles, uint16_t overhead)
+{
+  Serial.print(what);
+  Serial.print(cycles - overhead);
+  Serial.println(" cycles");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(100);
+  Serial.println("idPushButton ISR benchmark ...");
+
+  button1.startMonitoring();
+  reg = portInputRegister(digitalPinToPort(PB1));
+  mask = digitalPinToBitMask(PB1);
+
+  TCCR1A = 0; // Timer1 normal mode, clocked at F_CPU
+  TCCR1B = _BV(CS10);
+
+  uint16_t empty, dr, pr, ch;
+  MEASURE(empty, );
+  MEASURE(dr, sink = digitalRead(PB1));
+  MEASURE(pr, sink = (*reg & mask) != 0);
+  MEASURE(ch, button1_ISR());
+
+  report("digitalRead(pin):          ", dr, empty);
+  report("*portInputRegister & mask: ", pr, empty);
+  report("change() (whole ISR body): ", ch, empty);
+  Serial.print("saved per edge:            ");
+  Serial.print(dr - pr);
+  Serial.println(" cycles");
+}
+
+void loop()
+{
+}
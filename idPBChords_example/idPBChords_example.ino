@@ -0,0 +1,83 @@
+/*
+  idPushButton chords example - three push buttons, each toggling its own LED, and pushed together
+  (within 50ms) acting as additional "buttons": 1+2 turns both LEDs on, 2+3 turns both off, all three blink them.
+  The individual callbacks are not called for the buttons released as a chord.
+
+  The example circuit:
+   * LEDs on pins 5 and 6 to ground (+ resistors)
+   * switches (normally open) from pins 3, 2 and 7 to GND (internal pull-up configured)
+
+ created 16.10.2026
+ */
+
+#define PB_CHORDS_SIZE 4
+#define PB_REGISTRY_SIZE 3 // the buttons served by the shared ISR
+#include <idPushButton.h>
+
+#define LED_R 6
+#define LED_G 5
+
+#define PB1 3
+#define PB2 2
+#define PB3 7
+
+// the ids of the buttons in the chords
+#define BTN1 (1 << 0)
+#define BTN2 (1 << 1)
+#define BTN3 (1 << 2)
+
+void Toggle(uint8_t led) { digitalWrite(led, !digitalRead(led)); }
+void ToggleG(unsigned long n) { Toggle(LED_G); }
+void ToggleR(unsigned long n) { Toggle(LED_R); }
+void ToggleBoth(unsigned long n) { Toggle(LED_G); Toggle(LED_R); }
+
+void OnChord(uint8_t chord, unsigned long held)
+{
+  switch(chord)
+  {
+    case BTN1 | BTN2:
+      digitalWrite(LED_G, HIGH);
+      digitalWrite(LED_R, HIGH);
+      break;
+    case BTN2 | BTN3:
+      digitalWrite(LED_G, LOW);
+      digitalWrite(LED_R, LOW);
+      break;
+    case BTN1 | BTN2 | BTN3:
+      digitalWrite(LED_G, HIGH);
+      digitalWrite(LED_R, LOW);
+      break;
+  }
+  Serial.print("chord ");
+  Serial.print(chord, BIN);
+  Serial.print(" held ");
+  Serial.print(held);
+  Serial.println("ms");
+}
+
+PBmonitor<LOW> button1(PB1, ToggleG); // served by the shared ISR
+PBmonitor<LOW> button2(PB2, ToggleR);
+PBmonitor<LOW> button3(PB3, ToggleBoth);
+PBchords chords(OnChord, 50);
+
+void setup()
+{
+  Serial.begin(115200);
+  pinMode(LED_G, OUTPUT);
+  pinMode(LED_R, OUTPUT);
+  chords.add(BTN1 | BTN2);
+  chords.add(BTN2 | BTN3);
+  chords.add(BTN1 | BTN2 | BTN3);
+  button1.setChords(&chords, 0);
+  button2.setChords(&chords, 1);
+  button3.setChords(&chords, 2);
+  button1.startMonitoring();
+  button2.startMonitoring();
+  button3.startMonitoring();
+  Serial.println("Push buttons and chords ready ...");
+}
+
+void loop()
+{
+  // EVERYTHING is interrupt driven
+}
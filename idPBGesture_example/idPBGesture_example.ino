@@ -0,0 +1,69 @@
+/*
+  idPushButton gesture example - clicks, double clicks, long presses and auto repeat from a single push button
+  The button is monitored in deferred mode: the ISR only records the edges, the gesture state machine
+  is run from loop() by poll(), so no timing has to be done in the callback
+
+  The example circuit:
+   * LED on pin 6 to ground (+ resistor)
+   * switch (normally open) from pin 3 to GND (internal pull-up configured)
+
+ created 16.10.2026
+ */
+
+#define PB_QUEUE_SIZE 16 // enables the deferred mode
+#include <idPushButton.h>
+
+#define LED 6
+#define PB1 3
+
+int level = 0; // LED brightness
+
+void OnGesture(uint8_t event, uint8_t count, unsigned long held)
+{
+  switch(event)
+  {
+    case PB_CLICK: // toggle
+      level = level ? 0 : 255;
+      Serial.println("click");
+      break;
+    case PB_DOUBLECLICK: // half brightness
+      level = 64;
+      Serial.println("double click");
+      break;
+    case PB_MULTICLICK:
+      Serial.print(count);
+      Serial.println(" clicks");
+      break;
+    case PB_LONGPRESS: // start dimming
+      Serial.println("long press");
+    case PB_REPEAT: // and keep dimming while held down
+      level = level > 16 ? level - 16 : 0;
+      break;
+    case PB_RELEASE:
+      Serial.print("released after ");
+      Serial.print(held);
+      Serial.println("ms");
+      break;
+  }
+  analogWrite(LED, level);
+}
+
+void Unused(unsigned long n) { }
+
+PUSH_BUTTON_L(button1, PB1, Unused, ONRELEASE);
+PBgesture gesture1(OnGesture, 600, 150); // long press after 600ms, then repeat every 150ms
+
+void setup()
+{
+  Serial.begin(115200);
+  pinMode(LED, OUTPUT);
+  button1.setGesture(&gesture1); // the edges go to the gesture state machine
+  button1.startMonitoring();
+  Serial.println("Push button gestures ready ...");
+}
+
+void loop()
+{
+  button1.poll(); // processes the recorded edges and checks the gesture timeouts
+  // any other (non blocking) work
+}
@@ -0,0 +1,47 @@
+/*
+  idPushButton resistor ladder example - the 5 buttons of an LCD keypad shield on the single analog pin A0
+  The ADC runs free and its interrupt feeds the readings to PBladder, no pin change interrupt is used.
+  The callbacks are the same PBcallback functions as used with PBmonitor (on release the time held is passed).
+
+  The example circuit:
+   * LCD keypad shield (buttons RIGHT, UP, DOWN, LEFT, SELECT wired as a resistor ladder to A0, pull-up to 5V)
+   * LED on pin 13
+
+ created 16.10.2026
+ */
+
+#include <idPushButton.h>
+
+#define LED 13
+
+void Report(const char *name, unsigned long n)
+{
+  Serial.print(name);
+  Serial.print(" held for ");
+  Serial.print(n);
+  Serial.println("ms");
+}
+void Right(unsigned long n) { Report("RIGHT", n); }
+void Up(unsigned long n) { Report("UP", n); }
+void Down(unsigned long n) { Report("DOWN", n); }
+void Left(unsigned long n) { Report("LEFT", n); }
+void Select(unsigned long n) { digitalWrite(LED, !digitalRead(LED)); Report("SELECT", n); }
+
+const uint16_t levels[5] = { 0, 100, 257, 410, 640 }; // the readings with each of the buttons pushed
+const PBcallback callbacks[5] = { Right, Up, Down, Left, Select };
+PBladder<5> keypad(A0, levels, callbacks); // idle (none pushed) reads 1023
+
+PB_LADDER_ON_ADC(keypad);
+
+void setup()
+{
+  Serial.begin(115200);
+  pinMode(LED, OUTPUT);
+  keypad.startMonitoring();
+  Serial.println("Keypad ready ...");
+}
+
+void loop()
+{
+  // EVERYTHING is interrupt driven
+}
@@ -0,0 +1,45 @@
+/*
+  idPushButton low power example - the MCU sleeps between the button events instead of running loop() idle
+  While no button is pushed it is powered down (woken by the pin change interrupts of the buttons), while a button
+  is held it sleeps in idle mode (the timers run, so the time held is measured exactly). The watchdog wakes it
+  every second in power down to keep millis() going.
+  The buttons are served by the shared ISR (constructed without ISR) so PBpower knows about them. The pins use pin
+  change interrupts (not INT0/INT1 - these wake from power down only on a level, PBpower would use the idle mode).
+
+  The example circuit:
+   * LEDs on pins 5 and 6 to ground (+ resistors)
+   * switches (normally open) from pins 7 and 8 to GND (internal pull-up configured)
+
+ created 16.10.2026
+ */
+
+#define PB_REGISTRY_SIZE 2 // the buttons served by the shared ISR
+#include <idPushButton.h>
+
+#define LED_R 6
+#define LED_G 5
+
+#define PB1 7
+#define PB2 8
+
+void ToggleG(unsigned long n) { digitalWrite(LED_G, !digitalRead(LED_G)); }
+void ToggleR(unsigned long n) { digitalWrite(LED_R, !digitalRead(LED_R)); }
+
+PBmonitor<LOW> button1(PB1, ToggleG);
+PBmonitor<LOW> button2(PB2, ToggleR);
+
+PB_POWER_ON_WDT;
+
+void setup()
+{
+  pinMode(LED_G, OUTPUT);
+  pinMode(LED_R, OUTPUT);
+  button1.startMonitoring();
+  button2.startMonitoring();
+  PBpower::setWatchdog(WDTO_1S);
+}
+
+void loop()
+{
+  PBpower::sleep(); // until the next interrupt, as deep as the buttons allow
+}
@@ -0,0 +1,41 @@
+/*
+  idPushButton key matrix example - a 4x4 keypad read by PBmatrix
+  Nothing runs while no key is touched: the columns wait for an interrupt, the matrix is scanned (from loop)
+  only while a key is down. Prints the key pressed, and on release how long it was held down.
+
+  The example circuit:
+   * 4x4 keypad (with a diode in series with each key to allow any number of keys to be pushed at once)
+   * rows on pins 4, 5, 6 and 7, columns on pins 8, 9, 10 and 11 (internal pull-ups configured)
+
+ created 16.10.2026
+ */
+
+#define PB_REGISTRY_SIZE 4 // the columns served by the shared ISR
+#include <idPushButton.h>
+
+const uint8_t rows[4] = { 4, 5, 6, 7 };
+const uint8_t cols[4] = { 8, 9, 10, 11 }; // all on one port (PORTB on Uno)
+const char keys[] = "123A456B789C*0#D";
+
+void OnKey(uint8_t key, unsigned long n)
+{
+  Serial.print(keys[key]);
+  Serial.print(" held for ");
+  Serial.print(n);
+  Serial.println("ms");
+}
+
+PBmatrix<4, 4> keypad(rows, cols, OnKey); // the columns served by the shared ISR
+
+void setup()
+{
+  Serial.begin(115200);
+  keypad.startMonitoring();
+  Serial.println("Keypad ready ...");
+}
+
+void loop()
+{
+  keypad.poll(); // scans while a key is touched, returns at once otherwise
+  // any other (non blocking) work
+}
@@ -13,6 +13,7 @@
  by Dejan 
  */
 
+//#define PB_STATS 1 // uncomment to print the counters of the buttons every 10 seconds
 #include "idPushButton.h"
 
 #define BOARD_LED 13
@@ -258,6 +259,17 @@ void loop() {
   Serial.print(button2.isInCallback()?" 2-inCB":"       ");
   Serial.print(button3.isInCallback()?" 3-inCB":"       ");
   Serial.println();
+#if PB_STATS
+  if(cnt%10==0)
+  {
+    Serial.print("Button #1: ");
+    PBprintStats(Serial, button1.snapshot());
+    Serial.print("Button #2: ");
+    PBprintStats(Serial, button2.snapshot());
+    Serial.print("Button #3: ");
+    PBprintStats(Serial, button3.snapshot());
+  }
+#endif
 /*
   if(cnt==10)
   {
@@ -31,7 +31,9 @@
 #ifndef idPushButton_H__
 #define idPushButton_H__
 
-#if defined(ARDUINO) && (ARDUINO >= 100)
+#if defined(PB_HOST)
+#include "idPBhost.h" // host (PC) simulation of the hardware - virtual clock, pins and interrupts
+#elif defined(ARDUINO) && (ARDUINO >= 100)
 #include <Arduino.h>
 #else
 #include <WProgram.h>
@@ -39,211 +41,2639 @@
 
 #define IDPUSHBUTTON_VERSION "0.2" 
 
-//#define EI_ARDUINO_INTERRUPTED_PIN
+#if !defined(PB_HOST) && !PB_ATOMIC // (PB_ATOMIC attaches the ISRs by attachInterrupt() of the core)
+#define EI_ARDUINO_INTERRUPTED_PIN // arduinoInterruptedPin tells the shared ISR (PBregistry) which pin changed
 #include <EnableInterrupt.h>
 // from https://github.com/GreyGnome/EnableInterrupt.git
+#endif
+#if defined(__AVR__)
+#include <avr/sleep.h> // PBpower
+#include <avr/wdt.h>
+#endif
+
+
+// Macros to automate Push button object instatiation with interrupt service routine global function definition 
+// Interrupts needs a void function (not part of the class) to act as interrupt service routine that must be defined outside the class 
+// as a wrapper to member function to be called on button change state (from the interrupt)
+#define SET_PB(PBUTTON, PIN_BUT, FP_CALLB, FP_ISR, TYPE, POR, T_IGNORE) PBmonitor<TYPE> PBUTTON(PIN_BUT, FP_CALLB, PBUTTON##_ISR, POR, T_IGNORE); \
+void PBUTTON##_ISR() { PBUTTON.change(); }
+#define PUSH_BUTTON_L(PBUTTON, PIN_BUT, FP_CALLB, POR) PBmonitor<false> PBUTTON(PIN_BUT, FP_CALLB, PBUTTON##_ISR, POR); \
+void PBUTTON##_ISR() { PBUTTON.change(); }
+#define PUSH_BUTTON_H(PBUTTON, PIN_BUT, FP_CALLB, POR) PBmonitor<true> PBUTTON(PIN_BUT, FP_CALLB, PBUTTON##_ISR, POR); \
+void PBUTTON##_ISR() { PBUTTON.change(); }
+// bank of push buttons on the same port sharing a single ISR, PINS and FP_CALLBS are arrays of N pins / callbacks
+#define PUSH_BUTTON_BANK(PBANK, N, PINS, FP_CALLBS, TYPE, POR) PBmonitorBank<N, TYPE> PBANK(PINS, FP_CALLBS, PBANK##_ISR, POR); \
+void PBANK##_ISR() { PBANK.change(); }
+
+typedef void (*ISR)(); // pointer to void function (to act as interrupt service routine)
+#if defined(__AVR__)
+typedef volatile uint8_t PBportReg; // input register of a port (PINx) - resolved once, read directly in the ISR
+typedef uint8_t PBportMask; // bit of the pin in the port input register
+#else
+typedef volatile uint32_t PBportReg;
+typedef uint32_t PBportMask;
+#endif
+typedef void (*PBcallback) (unsigned long); // pointer to void function taking one int (should be unsigned long) 
+// to be called from the push button monitor object when the button wil be released passing the number od miliseconds the button was held down
+typedef void (*PBcallbackCtx) (void *, unsigned long); // the same, also passing a user context (object, struct...) given with the callback
+union PBanyCallback // either of the two - which one is kept by the owner (no casts between function pointer types)
+{
+  PBanyCallback(PBcallback f) : plain(f) { }
+  PBanyCallback(PBcallbackCtx f) : withContext(f) { }
+  PBcallback plain;
+  PBcallbackCtx withContext;
+};
+
+// member function as a context callback (the context is the object, needs PB_REGISTRY_SIZE), no heap used:
+//   PBmonitor<LOW> button(3, PBmethod<Leds, &Leds::flash>, &leds);
+template <class T, void (T::*M)(unsigned long)>
+void PBmethod(void *obj, unsigned long t) { (static_cast<T *>(obj)->*M)(t); }
+
+#define ONRELEASE false
+#define ONPRESS   true
+
+// Timebase of the press durations - define PB_TIMEBASE before including this file:
+//  PB_TIMEBASE_MILLIS - millis() (default), the callbacks get the time held in ms
+//  PB_TIMEBASE_MICROS - micros(), the callbacks get the time held in us
+//  PB_TIMEBASE_TIMER  - a free running hardware counter read by PB_TIMER_TICKS() that counts PB_TIMER_TICKS_PER_MS
+//                       (up to 3276, so the 20ms default debounce time fits 16 bits) ticks a ms, the callbacks get the
+//                       time held in us. E.g. Timer1 of an Uno at 16MHz/64:
+//                         #define PB_TIMER_TICKS() TCNT1
+//                         #define PB_TIMER_TICKS_PER_MS 250
+//                       and TCCR1A = 0; TCCR1B = _BV(CS11) | _BV(CS10); in setup() (no PWM on pins 9 and 10 then)
+// With MICROS and TIMER PBmonitor stores only the low 16 bits of the counter when pushed down and the debounce time in
+// 16 bits of ticks (so up to PB_UBDELAY_MAX_MS, 65ms with micros()) - with millis() 8 bytes as before. The wraps of the
+// counter are counted from millis() only when the time held is reported, so presses are timed to the tick - the longer
+// ones than PB_HELD_MAX_MS (71 minutes with micros()) are reported as PB_HELD_MAX_MS.
+// .. note - the finer timing costs no RAM, but saves none either: millis() when pushed down is kept whole (32 bits), as
+// a 16 bit one would save 2 bytes but could not tell a press of 70s from one of 4s - held() would wrap, not saturate.
+#define PB_TIMEBASE_MILLIS 0
+#define PB_TIMEBASE_MICROS 1
+#define PB_TIMEBASE_TIMER 2
+#ifndef PB_TIMEBASE
+#define PB_TIMEBASE PB_TIMEBASE_MILLIS
+#endif
+#if PB_TIMEBASE == PB_TIMEBASE_MILLIS
+typedef uint8_t PBtick; // (not used - the edges are timed by millis())
+#define PB_TICKS() 0
+#define PB_UBDELAY_MAX_MS 0xFFFFFFFFUL
+#else
+typedef uint16_t PBtick; // the low 16 bits of the timebase counter
+#if PB_TIMEBASE == PB_TIMEBASE_MICROS
+#define PB_TICKS() ((PBtick)micros())
+#define PB_TICKS_PER_MS 1000UL
+#else
+#if !defined(PB_TIMER_TICKS) || !defined(PB_TIMER_TICKS_PER_MS)
+#error "PB_TIMEBASE_TIMER needs PB_TIMER_TICKS() and PB_TIMER_TICKS_PER_MS"
+#endif
+#define PB_TICKS() ((PBtick)(PB_TIMER_TICKS()))
+#define PB_TICKS_PER_MS ((unsigned long)(PB_TIMER_TICKS_PER_MS))
+#endif
+static_assert(PB_TICKS_PER_MS > 0 && PB_TICKS_PER_MS * 20 <= 0xFFFF, "PB_TIMER_TICKS_PER_MS must be 1..3276 (20ms in 16 bits)");
+// the longest time held reported - its ticks and its us still fit an unsigned long
+#define PB_HELD_MAX_MS (0xFFFFFFFFUL / (PB_TICKS_PER_MS > 1000 ? PB_TICKS_PER_MS : 1000) - 1)
+// the longest debounce time - its ticks still fit 16 bits
+#define PB_UBDELAY_MAX_MS (0xFFFFUL / PB_TICKS_PER_MS)
+#endif
+
+// Atomic backend - for multicore / RTOS targets with <atomic> (ESP32, RP2040, ...) define PB_ATOMIC 1 before including
+// this file. Instead of SREG and noInterrupts() PBmonitor then uses atomics: every edge seen by change() goes through
+// the event queue (a lock-free multi producer / multi consumer ring) and the queued edges are processed, in order and
+// only once, by whoever gets hold of the button - the ISR itself (immediate mode) or any task calling poll() (deferred
+// mode) - the others do not wait, they leave their edges to it. Configure the buttons before starting them; the leading
+// edge mode, PB_ADAPTIVE, PB_STATS and PB_TRACE_SIZE are not multicore safe, nor are PBchords (process all the buttons
+// of a PBchords on one core) and PBscheduler::start() (call it on one core only, the callbacks calling it included) -
+// their critical sections mask the interrupts of the own core only. In immediate mode the callbacks run in the ISR
+// with the interrupts of the core masked (no PBenable()), so keep them short - or use the deferred mode.
+#ifndef PB_ATOMIC
+#define PB_ATOMIC 0
+#endif
+#if PB_ATOMIC
+#include <atomic>
+#endif
+
+// Critical sections and pin interrupts - the objects guard the state they share with their ISRs by
+//   PBirq irq = PBdisable(); ... PBrestore(irq); (the interrupts off, then back as they were)
+// run the callbacks from the ISRs between PBenable() and PBrestore() (the interrupts on, so millis() and the other
+// ISRs keep going) and set the ISR of a pin by PBattach(pin, isr, mode) / PBdetach(pin).
+// By default these are SREG and the EnableInterrupt library (any pin, the shared ISR of PBregistry learns the pin from
+// arduinoInterruptedPin). With PB_ATOMIC they are the interrupt mask of the core - PRIMASK of the Cortex-M cores
+// (RP2040, SAMD, nRF, STM32...) or the interrupt level of the ESP32, other cores define PB_IRQ_SAVE() (the interrupts
+// off, returns the previous state) and PB_IRQ_RESTORE(s) - and attachInterrupt() of the core (the pins with an
+// interrupt), PBregistry then gives every entry an ISR of its own. The mask holds off the ISRs of the own core only.
+#if PB_ATOMIC
+#if !defined(PB_IRQ_SAVE)
+#if defined(__CORTEX_M) // CMSIS
+inline uint32_t PBsavePrimask() { uint32_t s = __get_PRIMASK(); __disable_irq(); return s; }
+#define PB_IRQ_SAVE() PBsavePrimask()
+#define PB_IRQ_RESTORE(s) __set_PRIMASK(s)
+#elif defined(ARDUINO_ARCH_ESP32)
+#define PB_IRQ_SAVE() portSET_INTERRUPT_MASK_FROM_ISR()
+#define PB_IRQ_RESTORE(s) portCLEAR_INTERRUPT_MASK_FROM_ISR(s)
+#else
+#error "PB_ATOMIC needs PB_IRQ_SAVE() and PB_IRQ_RESTORE(s) on this core"
+#endif
+#endif
+typedef uint32_t PBirq; // the interrupt mask saved
+inline PBirq PBdisable() { PBirq s = PB_IRQ_SAVE(); std::atomic_signal_fence(std::memory_order_seq_cst); return s; }
+inline PBirq PBenable() { PBirq s = PB_IRQ_SAVE(); interrupts(); return s; }
+inline void PBrestore(PBirq s) { std::atomic_signal_fence(std::memory_order_seq_cst); PB_IRQ_RESTORE(s); }
+inline void PBattach(uint8_t pin, ISR isr, uint8_t mode) { attachInterrupt(digitalPinToInterrupt(pin), isr, mode); }
+inline void PBdetach(uint8_t pin) { detachInterrupt(digitalPinToInterrupt(pin)); }
+#else
+typedef uint8_t PBirq; // SREG saved
+inline PBirq PBdisable() { PBirq s = SREG; noInterrupts(); return s; }
+inline PBirq PBenable() { PBirq s = SREG; interrupts(); return s; }
+inline void PBrestore(PBirq s) { SREG = s; }
+inline void PBattach(uint8_t pin, ISR isr, uint8_t mode) { enableInterrupt(pin, isr, mode); }
+inline void PBdetach(uint8_t pin) { disableInterrupt(pin); }
+#endif
+
+// Deferred dispatch - define PB_QUEUE_SIZE (power of 2, up to 128) before including this file to enable it.
+// In deferred mode change() only stores the edge in a per button ring buffer and the callbacks are run
+// from loop() by calling poll(), so presses are not lost while a (long) callback is being executed
+#ifndef PB_QUEUE_SIZE
+#if PB_ATOMIC
+#define PB_QUEUE_SIZE 16 // the atomic backend passes all the edges through the queue
+#else
+#define PB_QUEUE_SIZE 0 // 0 = deferred mode not compiled in (no RAM used)
+#endif
+#endif
+#if PB_ATOMIC && PB_QUEUE_SIZE == 0
+#error "PB_ATOMIC needs PB_QUEUE_SIZE > 0"
+#endif
+
+struct PBevent // a single edge seen by change()
+{
+  uint8_t id; // the pin the edge was seen on
+  uint8_t edge; // level of the pin after the edge (HIGH = rising, LOW = falling)
+  unsigned long t; // millis() at the time of the edge
+#if PB_TIMEBASE != PB_TIMEBASE_MILLIS
+  PBtick tick; // the timebase counter at the time of the edge
+  PBtick ticks() const { return tick; }
+#else
+  PBtick ticks() const { return 0; }
+#endif
+};
+
+#if PB_ATOMIC
+// Lock free multi producer / multi consumer ring buffer of edge events (bounded queue of D. Vyukov): every slot
+// has a sequence number telling whether it is free for the push or filled for the pop of the current lap, a slot is
+// claimed by a CAS on head (push) or tail (pop), written / read, then handed over by publishing its next sequence
+template <uint8_t SIZE>
+class PBeventQueue
+{
+  static_assert(SIZE > 0 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "PB_QUEUE_SIZE must be a power of 2 up to 128");
+  public:
+    PBeventQueue() : head(0), tail(0), overflows(0)
+    {
+      for(unsigned int i=0; i<SIZE; i++)
+        buf[i].seq.store(i, std::memory_order_relaxed);
+    }
+    bool push(uint8_t id, uint8_t edge, unsigned long t, PBtick tick = 0) // from any core / task / ISR
+    {
+      unsigned int pos = head.load(std::memory_order_relaxed);
+      Cell *c;
+      for(;;)
+      {
+        c = &buf[pos & (SIZE - 1)];
+        int d = (int)(c->seq.load(std::memory_order_acquire) - pos);
+        if(d == 0 && head.compare_exchange_weak(pos, pos + 1)) // free - claimed
+          break;
+        if(d < 0) // full - the event is lost
+        {
+          overflows.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        if(d > 0) // taken by another push meanwhile
+          pos = head.load(std::memory_order_relaxed);
+      }
+      c->e.id = id;
+      c->e.edge = edge;
+      c->e.t = t;
+#if PB_TIMEBASE != PB_TIMEBASE_MILLIS
+      c->e.tick = tick;
+#else
+      (void)tick; // (not used with millis())
+#endif
+      c->seq.store(pos + 1, std::memory_order_release); // publish only after the slot is written
+      return true;
+    }
+    bool pop(PBevent &e) // from any core / task
+    {
+      unsigned int pos = tail.load(std::memory_order_relaxed);
+      Cell *c;
+      for(;;)
+      {
+        c = &buf[pos & (SIZE - 1)];
+        int d = (int)(c->seq.load(std::memory_order_acquire) - (pos + 1));
+        if(d == 0 && tail.compare_exchange_weak(pos, pos + 1)) // filled - claimed
+          break;
+        if(d < 0) // empty
+          return false;
+        if(d > 0) // taken by another pop meanwhile
+          pos = tail.load(std::memory_order_relaxed);
+      }
+      e = c->e;
+      c->seq.store(pos + SIZE, std::memory_order_release); // free the slot (for the next lap) only after it is read
+      return true;
+    }
+    uint8_t pending() const { return (uint8_t)(head.load() - tail.load()); }
+    unsigned int getOverflows() const { return overflows.load(std::memory_order_relaxed); }
+    void clearOverflows() { overflows.store(0, std::memory_order_relaxed); }
+
+  private:
+    struct Cell
+    {
+      std::atomic<unsigned int> seq; // pos: free for the push at pos, pos + 1: filled for the pop at pos
+      PBevent e;
+    };
+    std::atomic<unsigned int> head; // next slot to be pushed
+    std::atomic<unsigned int> tail; // next slot to be popped
+    std::atomic<unsigned int> overflows; // number of events lost because the queue was full
+    Cell buf[SIZE];
+};
+#else
+// Lock free single producer (the ISR) / single consumer (loop) ring buffer of edge events
+// head is written only by push() and tail only by pop(), both are single byte so reads/writes are atomic
+template <uint8_t SIZE>
+class PBeventQueue
+{
+  static_assert(SIZE > 0 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "PB_QUEUE_SIZE must be a power of 2 up to 128");
+  public:
+    PBeventQueue() : head(0), tail(0), overflows(0) { }
+    bool push(uint8_t id, uint8_t edge, unsigned long t, PBtick tick = 0) // call from the ISR only
+    {
+      uint8_t h = head;
+      if((uint8_t)(h - tail) >= SIZE) // full - the event is lost
+      {
+        if(overflows != 0xFFFF)
+          overflows++;
+        return false;
+      }
+      volatile PBevent &e = buf[h & (SIZE - 1)];
+      e.id = id;
+      e.edge = edge;
+      e.t = t;
+#if PB_TIMEBASE != PB_TIMEBASE_MILLIS
+      e.tick = tick;
+#else
+      (void)tick; // (not used with millis())
+#endif
+      head = h + 1; // publish only after the slot is written
+      return true;
+    }
+    bool pop(PBevent &e) // call from loop() only
+    {
+      uint8_t t = tail;
+      if(t == head)
+        return false;
+      volatile PBevent &s = buf[t & (SIZE - 1)];
+      e.id = s.id;
+      e.edge = s.edge;
+      e.t = s.t;
+#if PB_TIMEBASE != PB_TIMEBASE_MILLIS
+      e.tick = s.tick;
+#endif
+      tail = t + 1; // free the slot only after it is read
+      return true;
+    }
+    uint8_t pending() const { return (uint8_t)(head - tail); }
+    unsigned int getOverflows() const
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      unsigned int o = overflows;
+      PBrestore(irq);
+      return o;
+    }
+    void clearOverflows() { PBirq irq = PBdisable(); overflows = 0; PBrestore(irq); }
+
+  private:
+    volatile uint8_t head; // next slot to be written (by the ISR)
+    volatile uint8_t tail; // next slot to be read (in loop)
+    volatile unsigned int overflows; // number of events lost because the queue was full
+    volatile PBevent buf[SIZE];
+};
+#endif
+
+// Instrumentation - define PB_STATS 1 before including this file to count what every PBmonitor does:
+// change() calls, releases rejected as bounces, presses dropped (callback still running), callbacks run,
+// min / max time spent in change() (without the callback) and a histogram of the callback durations.
+// When not enabled nothing is compiled in (no RAM, no code)
+#ifndef PB_STATS
+#define PB_STATS 0
+#endif
+#if PB_STATS
+#define PB_STAT(x) x
+#else
+#define PB_STAT(x)
+#endif
+#ifndef PB_STATS_BINS
+#define PB_STATS_BINS 8 // callback duration histogram bins: <1ms, <2ms, <4ms, ... , the last one counts all the longer
+#endif
+
+struct PBstats
+{
+  unsigned long edges; // change() calls
+  unsigned long rejected; // releases ignored because the button was held shorter than the debounce time (edges in the lockout window in leading edge mode)
+  unsigned long dropped; // presses ignored because the callback was still executing
+  unsigned long fired; // callbacks run
+  unsigned int isrMin; // shortest change() in micros (without the callback)
+  unsigned int isrMax; // longest change() in micros (without the callback)
+  unsigned long cbMax; // longest callback in ms
+  unsigned int cbHist[PB_STATS_BINS]; // callbacks by duration, bin i counts the ones shorter than 2^i ms
+  unsigned long lastCb; // duration of the last callback in micros (to be excluded from the change() time)
+
+  PBstats() { reset(); }
+  void reset()
+  {
+    edges = rejected = dropped = fired = 0;
+    isrMin = 0xFFFF;
+    isrMax = 0;
+    cbMax = lastCb = 0;
+    for(uint8_t i=0; i<PB_STATS_BINS; i++)
+      cbHist[i] = 0;
+  }
+  void isr(unsigned long us)
+  {
+    if(us > 0xFFFF)
+      us = 0xFFFF;
+    if(us < isrMin)
+      isrMin = us;
+    if(us > isrMax)
+      isrMax = us;
+  }
+  void callback(unsigned long us)
+  {
+    lastCb = us;
+    fired++;
+    unsigned long ms = us / 1000;
+    if(ms > cbMax)
+      cbMax = ms;
+    uint8_t bin = 0;
+    while(ms && bin < PB_STATS_BINS - 1) // number of bits of the duration
+    {
+      ms >>= 1;
+      bin++;
+    }
+    if(cbHist[bin] != 0xFFFF)
+      cbHist[bin]++;
+  }
+  void printTo(Print &p) const // one line dump, e.g. PBprintStats(Serial, button1.snapshot())
+  {
+    p.print("edges=");
+    p.print(edges);
+    p.print(" rejected=");
+    p.print(rejected);
+    p.print(" dropped=");
+    p.print(dropped);
+    p.print(" fired=");
+    p.print(fired);
+    p.print(" isr=");
+    p.print(edges ? isrMin : 0);
+    p.print("..");
+    p.print(isrMax);
+    p.print("us cb max=");
+    p.print(cbMax);
+    p.print("ms");
+    for(uint8_t i=0; i<PB_STATS_BINS; i++)
+    {
+      p.print(i < PB_STATS_BINS - 1 ? " <" : " >=");
+      p.print(1UL << (i < PB_STATS_BINS - 1 ? i : i - 1));
+      p.print("ms:");
+      p.print(cbHist[i]);
+    }
+    p.println();
+  }
+};
+
+inline void PBprintStats(Print &p, const PBstats &s) { s.printTo(p); }
+
+// Edge trace capture - define PB_TRACE_SIZE (up to 255) before including this file and attach a PBtrace to a button
+// with setTrace(): every edge change() sees is logged into a ring of PB_TRACE_SIZE 16 bit words (the oldest are
+// overwritten), so the raw edge sequence of a misbehaving unit can be dumped over Serial and replayed on a PC
+// (extras/host/pbReplay.cpp) as a deterministic regression test or benchmark.
+//
+// Word (one per edge):  bit 15     - unit of the delta: 0 = 4 microseconds, 1 = 1 millisecond
+//                       bits 14..1 - time since the previous edge (14 bits, saturates at 16383 ms)
+//                       bit 0      - level of the pin after the edge
+//                       The delta is truncated to the unit (4us up to 65ms, 1ms above) and every edge is timed from
+//                       the real time of the previous one, so a replay runs early by up to 3us (or 999us) an edge -
+//                       accumulating over the edges of the dump.
+// Binary dump (dump()): "PBTR", version (1), pin, type (LOW/HIGH), 0, number of words (16 bit), the words oldest first
+//                       - all 16 bit values little endian. The delta of the first word is relative to an earlier (lost)
+//                       edge or to the start of the capture.
+#ifndef PB_TRACE_SIZE
+#define PB_TRACE_SIZE 0 // 0 = trace capture not compiled in
+#endif
+static_assert(PB_TRACE_SIZE <= 255, "PB_TRACE_SIZE must be up to 255 (the ring is indexed and the dump counted in 8 bits)");
+
+class PBtrace
+{
+  public:
+    enum { VERSION = 1, SIZE = PB_TRACE_SIZE > 0 ? PB_TRACE_SIZE : 1 };
+    PBtrace() { clear(0, LOW, 0); }
+
+    void clear(uint8_t pinPB, bool type, unsigned long us) // restart the capture
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      head = count = 0;
+      last = us;
+      pin = pinPB;
+      bp.type = type;
+      bp.frozen = false;
+      PBrestore(irq);
+    }
+
+    void record(bool level, unsigned long us) // called from the ISR
+    {
+      if(bp.frozen)
+        return;
+      unsigned long d = us - last;
+      last = us;
+      uint16_t w;
+      if(d < 4UL * 0x4000)
+        w = (uint16_t)((d >> 2) << 1);
+      else
+      {
+        d /= 1000;
+        w = 0x8000 | (uint16_t)((d > 0x3FFF ? 0x3FFF : d) << 1);
+      }
+      buf[head] = w | level;
+      head = head + 1 < SIZE ? head + 1 : 0;
+      if(count < SIZE)
+        count++;
+    }
+
+    static void decode(uint16_t w, unsigned long &us, bool &level) // one word -> delta in micros and level
+    {
+      level = w & 1;
+      us = (unsigned long)((w >> 1) & 0x3FFF) * (w & 0x8000 ? 1000 : 4);
+    }
+
+    uint8_t size() const { return count; }
+    uint16_t operator[](uint8_t i) const { return buf[(head + SIZE - count + i) % SIZE]; } // i-th oldest word
+    void freeze(bool f) { bp.frozen = f; } // stop / resume capturing
+
+    void dump(Print &p) // writes the binary dump, capturing is paused meanwhile
+    {
+      bool was = bp.frozen;
+      bp.frozen = true;
+      p.write((const uint8_t *)"PBTR", 4);
+      p.write((uint8_t)VERSION);
+      p.write(pin);
+      p.write((uint8_t)bp.type);
+      p.write((uint8_t)0);
+      p.write((uint8_t)count);
+      p.write((uint8_t)0);
+      for(uint8_t i=0; i<count; i++)
+      {
+        uint16_t w = (*this)[i];
+        p.write((uint8_t)(w & 0xFF));
+        p.write((uint8_t)(w >> 8));
+      }
+      bp.frozen = was;
+    }
+
+  private:
+    volatile uint16_t buf[SIZE]; // the words, a ring
+    volatile uint8_t head; // next word to be written
+    volatile uint8_t count; // words in the ring
+    unsigned long last; // micros() of the previous edge
+    uint8_t pin; // the pin traced
+    struct bitPack
+    {
+      uint8_t type:1; // the type of the button (active LOW/HIGH)
+      uint8_t frozen:1; // not capturing
+    } bp;
+};
+
+// Gesture events passed to a PBgestureCallback
+#define PB_CLICK        1 // a short press (reported once no other press followed within the multi-click gap)
+#define PB_DOUBLECLICK  2 // two short presses in a row
+#define PB_MULTICLICK   3 // three or more short presses in a row (count is passed)
+#define PB_LONGPRESS    4 // held down longer than the long press time - reported while still held
+#define PB_REPEAT       5 // still held after the long press - reported every repeat interval
+#define PB_RELEASE      6 // released - reported on every release with the time the button was held down
+
+// pointer to void function to be called on a gesture, passing the event, the number of clicks and the time held down in ms
+typedef void (*PBgestureCallback) (uint8_t, uint8_t, unsigned long);
+
+// Gesture state machine of a single push button - recognizes clicks, double/multiple clicks, long presses 
+// (while still held) with auto repeat. It is fed with the raw edges and their timestamps by edge() and 
+// all the timing is done in service(), so it is meant to be run from loop() - never from the ISR.
+// Attach it to a PBmonitor in deferred mode by setGesture() and poll() will do both.
+class PBgesture
+{
+  public:
+    PBgesture(PBgestureCallback f, unsigned int longPressMs = 800, unsigned int repeatMs = 200, unsigned int multiClickMs = 250, unsigned int debounceMs = 20) :
+      callback(f), debounce(debounceMs), multiClick(multiClickMs), longPress(longPressMs), repeat(repeatMs),
+      rawTime(0), pressTime(0), releaseTime(0), lastRepeat(0), clicks(0)
+    { 
+      bp.raw = false;
+      bp.stable = false;
+      bp.longFired = false;
+    }
+
+    void edge(bool pushed, unsigned long t) // a (possibly bouncing) edge, pushed is the level after it
+    {
+      settle(t);
+      bp.raw = pushed;
+      rawTime = t;
+    }
+
+    void service(unsigned long now) // checks the timeouts, call it often
+    {
+      settle(now);
+      if(bp.stable)
+      {
+        if(!bp.longFired && now - pressTime >= longPress)
+        {
+          bp.longFired = true;
+          lastRepeat = now;
+          clicks = 0;
+          callback(PB_LONGPRESS, 0, now - pressTime);
+        }
+        else if(bp.longFired && repeat && now - lastRepeat >= repeat)
+        {
+          lastRepeat += repeat;
+          callback(PB_REPEAT, 0, now - pressTime);
+        }
+      }
+      else if(clicks && now - releaseTime >= multiClick) // no other press followed - report the clicks
+      {
+        uint8_t c = clicks;
+        clicks = 0;
+        callback(c == 1 ? PB_CLICK : c == 2 ? PB_DOUBLECLICK : PB_MULTICLICK, c, releaseTime - pressTime);
+      }
+    }
+
+    bool isPressed() const { return bp.stable; } // debounced state
+    bool isIdle() const { return !bp.stable && !clicks && bp.raw == bp.stable; } // no timeout pending
+    void setLongPress(unsigned int t) { longPress = t; }
+    void setRepeat(unsigned int t) { repeat = t; } // 0 = no repeat
+    void setMultiClick(unsigned int t) { multiClick = t; }
+    void setDebounce(unsigned int t) { debounce = t; }
+    void setCallback(PBgestureCallback f) { callback = f; }
+
+  private:
+    void settle(unsigned long now) // the raw level has been stable long enough - take it
+    {
+      if(bp.raw == bp.stable || now - rawTime < debounce)
+        return;
+      bp.stable = bp.raw;
+      if(bp.stable) // pushed down
+      {
+        pressTime = rawTime;
+        bp.longFired = false;
+      }
+      else // released
+      {
+        releaseTime = rawTime;
+        if(!bp.longFired && clicks < 255)
+          clicks++;
+        callback(PB_RELEASE, clicks, releaseTime - pressTime);
+      }
+    }
+
+    PBgestureCallback callback; // function to be called on a gesture
+    unsigned int debounce; // time the level must be stable to be registered
+    unsigned int multiClick; // max time between the clicks of a double / multiple click
+    unsigned int longPress; // time held down to be a long press
+    unsigned int repeat; // repeat interval after a long press
+    unsigned long rawTime; // time of the last edge
+    unsigned long pressTime; // time the button was pushed down (the last edge of the make bounce)
+    unsigned long releaseTime; // time the button was released
+    unsigned long lastRepeat; // time of the last long press / repeat event
+    uint8_t clicks; // short presses not yet reported
+    struct bitPack
+    {
+      uint8_t raw:1; // level after the last edge (1 = pushed)
+      uint8_t stable:1; // debounced state (1 = pushed)
+      uint8_t longFired:1; // long press already reported for this press
+    } bp;
+};
+
+// Registry of the buttons served by the shared ISR - maps the pin that raised the interrupt to its object through 
+// a small static table, so buttons constructed without an ISR need no global wrapper function (no macros).
+// The pin comes from the EnableInterrupt library (arduinoInterruptedPin, EI_ARDUINO_INTERRUPTED_PIN is defined above),
+// with PB_ATOMIC every entry of the table has an ISR of its own instead (isrOf())
+// Opt-in - define PB_REGISTRY_SIZE (e.g. 8) before including this file to declare the buttons, encoders and matrices
+// without an ISR and the buttons with a context callback. The table takes 7 bytes a pin on AVR (a pointer to the
+// object, its change() and isIdle() and the pin) and every PBmonitor one pointer more for the context; with 0 (default)
+// none of it is compiled and only the constructors taking an ISR are there.
+#ifndef PB_REGISTRY_SIZE
+#define PB_REGISTRY_SIZE 0 // max number of pins served by the shared ISR
+#endif
+
+class PBregistry
+{
+  public:
+    typedef void (*Change)(void *); // calls change() of the object
+    typedef bool (*Idle)(void *); // calls isIdle() of the object
+
+    template <class T>
+    static void changeOf(void *obj) { static_cast<T *>(obj)->change(); }
+    template <class T>
+    static bool idleOf(void *obj) { return static_cast<T *>(obj)->isIdle(); }
+
+    static bool add(uint8_t pin, void *obj, Change f, Idle i = 0) // false if the table is full (i = 0 - always idle)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      Entry *e = find(pin);
+      if(!e)
+        e = find(pin, false); // a free entry
+      if(e)
+      {
+        e->obj = obj;
+        e->change = f;
+        e->idle = i;
+        e->pin = pin;
+      }
+      PBrestore(irq);
+      return e != 0;
+    }
+
+    static void remove(uint8_t pin)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      Entry *e = find(pin);
+      if(e)
+        e->obj = 0;
+      PBrestore(irq);
+    }
+
+    static ISR isrOf(uint8_t pin) // the ISR to attach to the pin once added
+    {
+#if PB_ATOMIC
+      Entry *e = find(pin);
+      return e ? isrAt(e - table(), Index<0>()) : 0;
+#else
+      (void)pin; // (the shared ISR learns it from arduinoInterruptedPin)
+      return dispatch;
+#endif
+    }
+
+#if !PB_ATOMIC
+    static void dispatch() // the shared ISR
+    {
+      Entry *e = find(arduinoInterruptedPin);
+      if(e)
+        e->change(e->obj);
+    }
+#endif
+
+    static bool isIdle() // none of the objects served has anything pending (PBpower may sleep deeply)
+    {
+#if PB_REGISTRY_SIZE > 0
+      Entry *t = table();
+      for(uint8_t i=0; i<PB_REGISTRY_SIZE; i++)
+        if(t[i].obj && t[i].idle && !t[i].idle(t[i].obj))
+          return false;
+#endif
+      return true;
+    }
+
+    // true if a pin served uses an external interrupt (INTx) - on edges it wakes the MCU only from the idle sleep
+    static bool needsClock()
+    {
+#if defined(__AVR__) && defined(digitalPinToInterrupt) && !defined(EI_NOTEXTERNAL) && PB_REGISTRY_SIZE > 0
+      Entry *t = table();
+      for(uint8_t i=0; i<PB_REGISTRY_SIZE; i++)
+        if(t[i].obj && digitalPinToInterrupt(t[i].pin) != NOT_AN_INTERRUPT)
+          return true;
+#endif
+      return false;
+    }
+
+  private:
+    struct Entry
+    {
+      uint8_t pin; // pin of the button
+      void *obj; // the button object (0 = free entry)
+      Change change; // change() of the object
+      Idle idle; // isIdle() of the object (0 - always idle)
+    };
+#if PB_REGISTRY_SIZE > 0
+    static Entry *table() { static Entry t[PB_REGISTRY_SIZE]; return t; }
+#else
+    static Entry *table() { return 0; } // (not used - nothing is added)
+#endif
+#if PB_ATOMIC
+    template <uint8_t I>
+    static void serve() { Entry &e = table()[I]; if(e.obj) e.change(e.obj); } // the ISR of the entry I
+    template <uint8_t I> struct Index { };
+    static ISR isrAt(uint8_t, Index<PB_REGISTRY_SIZE>) { return 0; }
+    template <uint8_t I>
+    static ISR isrAt(uint8_t i, Index<I>) { return i == I ? serve<I> : isrAt(i, Index<I + 1>()); }
+#endif
+    static Entry *find(uint8_t pin, bool used = true) // the entry of the pin or a free one
+    {
+#if PB_REGISTRY_SIZE > 0
+      Entry *t = table();
+      for(uint8_t i=0; i<PB_REGISTRY_SIZE; i++)
+        if(used ? t[i].obj && t[i].pin == pin : !t[i].obj)
+          return t + i;
+#else
+      (void)pin; (void)used; // (no table)
+#endif
+      return 0;
+    }
+};
+
+// Low power - PBpower::sleep() called from loop() puts the MCU to sleep until the next interrupt. While all the objects
+// served by PBregistry are idle (nothing pushed, queued or timing) it powers down - the deepest sleep the pin change
+// interrupts still wake from. Otherwise (or if a pin uses an external interrupt INTx, which wakes from power down only
+// on a level) it sleeps in the idle mode: the timers run, so millis() and the press durations stay exact and loop()
+// runs at least every 1ms. millis() stops in power down - with PB_POWER_ON_WDT and setWatchdog(WDTO_...) the watchdog
+// wakes the MCU every period and adds it to millis() (up to a period is lost on every wake by a button).
+// Buttons with their own ISR are not known to PBregistry - check their isIdle() before calling sleep(). PBladder and
+// PBmonitorPolled need the ADC / the timer running - call sleep(false) (never powers down) with them.
+#define PB_AWAKE      0 // did not sleep
+#define PB_SLEEP_IDLE 1 // slept in idle mode
+#define PB_SLEEP_DEEP 2 // powered down
+
+#if defined(__AVR__)
+extern volatile unsigned long timer0_millis; // the millis() counter of the core (wiring.c)
+#endif
+
+class PBpower
+{
+  public:
+    static uint8_t sleep(bool deep = true) // sleeps until an interrupt, returns how (PB_AWAKE, PB_SLEEP_IDLE, PB_SLEEP_DEEP)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      uint8_t mode = deep && PBregistry::isIdle() && !PBregistry::needsClock() ? PB_SLEEP_DEEP : PB_SLEEP_IDLE;
+#if defined(SLEEP_MODE_PWR_DOWN) // avr/sleep.h
+      set_sleep_mode(mode == PB_SLEEP_DEEP ? SLEEP_MODE_PWR_DOWN : SLEEP_MODE_IDLE);
+      bool wdt = mode == PB_SLEEP_DEEP && period() >= 0;
+      if(wdt)
+        watchdog(true);
+      sleep_enable();
+      interrupts(); // the instruction after sei (sleep) is executed before any interrupt - none is missed
+      sleep_cpu();
+      sleep_disable();
+      if(wdt)
+        watchdog(false);
+      PBrestore(irq);
+#else
+      PBrestore(irq);
+      mode = PB_AWAKE;
+#endif
+      return mode;
+    }
+
+    // the watchdog period (WDTO_15MS ... WDTO_8S) that keeps millis() going in power down, -1 = off (millis() stops)
+    static void setWatchdog(int8_t wdto) { period() = wdto; }
+    static int8_t getWatchdog() { return period(); }
+#if defined(__AVR__)
+    static void tick() { timer0_millis += 16UL << period(); } // the watchdog ISR (PB_POWER_ON_WDT)
+#endif
+
+  private:
+    static int8_t &period() { static int8_t p = -1; return p; }
+#if defined(WDTCSR)
+    static void watchdog(bool on) // the watchdog in interrupt mode (no reset), the interrupts disabled
+    {
+      wdt_reset();
+      MCUSR &= ~_BV(WDRF);
+      WDTCSR = _BV(WDCE) | _BV(WDE);
+      WDTCSR = on ? _BV(WDIE) | (period() & 8 ? _BV(WDP3) : 0) | (period() & 7) : 0;
+    }
+#elif defined(SLEEP_MODE_PWR_DOWN)
+    static void watchdog(bool on) { }
+#endif
+};
+
+// Chords - buttons pushed together (within a time window) act as a single one. Define PB_CHORDS_SIZE (the most
+// chords, up to 255) before including this file, register the chords in a PBchords and join the buttons to it with
+// setChords(&chords, id) - id (0..7) is the bit of the button in the chord masks. The buttons keep the mask of the
+// ones pushed (pressed()) up to date from change(). When the first button of a group pushed within the window is
+// released and the group is a registered chord, the chord callback is called instead of the (ONRELEASE) callbacks
+// of all the buttons in it. ONPRESS buttons have already reacted by then - use ONRELEASE for the buttons in chords.
+// With PB_ATOMIC all the buttons of a PBchords must be processed on the same core.
+#ifndef PB_CHORDS_SIZE
+#define PB_CHORDS_SIZE 0 // 0 = chords not compiled in
+#endif
+
+// pointer to void function to be called on a chord, passing the chord (mask of the buttons) and the time held in ms
+typedef void (*PBchordCallback) (uint8_t, unsigned long);
+
+#if PB_CHORDS_SIZE > 0
+class PBchords
+{
+  public:
+    PBchords(PBchordCallback f, unsigned int windowMs = 50) : callback(f), window(windowMs), first(0), n(0)
+    {
+      down = group = consumed = 0;
+    }
+
+    // registers a chord (mask of 2 or more button ids), returns false if the table is full
+    bool add(uint8_t mask)
+    {
+      if(!(mask & (mask - 1)) || n >= PB_CHORDS_SIZE) // a single button is not a chord
+        return false;
+      if(find(mask))
+        return true;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      uint8_t i = n++;
+      for( ; i > 0 && chords[i - 1] > mask; i--) // keep the table sorted
+        chords[i] = chords[i - 1];
+      chords[i] = mask;
+      PBrestore(irq);
+      return true;
+    }
+
+    uint8_t pressed() const { return down; } // the buttons pushed
+    void setWindow(unsigned int t) { window = t; } // the buttons of a chord must be pushed within t ms
+    void setCallback(PBchordCallback f) { callback = f; }
+
+    // called by the buttons (from change() or poll()) when pushed (bit = their mask) ...
+    void press(uint8_t bit, unsigned long now)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      if(!down) // the first one of a new group
+      {
+        first = now;
+        group = 0;
+      }
+      down |= bit;
+      if(now - first <= window)
+        group |= bit;
+      PBrestore(irq);
+    }
+
+    // ... and when released, returns true if the callback of the button is not to be called (was in a chord);
+    // decide = false if it was pushed shorter than the debounce time (a glitch) - then it only leaves the group
+    bool release(uint8_t bit, unsigned long now, bool decide = true)
+    {
+      uint8_t chord = 0;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      bool suppress = decide && (consumed & bit);
+      unsigned long held = now - first;
+      if(!decide)
+        group &= ~bit;
+      else if(!suppress && (group & bit)) // the first one of the group released - decide
+      {
+        if(find(group))
+        {
+          chord = group;
+          consumed |= group;
+          suppress = true;
+        }
+        group = 0;
+      }
+      if(decide)
+        consumed &= ~bit;
+      down &= ~bit;
+      if(chord) // like the callbacks of the buttons - with the interrupts enabled
+      {
+        interrupts();
+        callback(chord, held);
+      }
+      PBrestore(irq);
+      return suppress;
+    }
+
+  private:
+    bool find(uint8_t mask) const // binary search in the sorted table
+    {
+      uint8_t lo = 0, hi = n;
+      while(lo < hi)
+      {
+        uint8_t mid = (lo + hi) >> 1;
+        if(chords[mid] < mask)
+          lo = mid + 1;
+        else if(chords[mid] > mask)
+          hi = mid;
+        else
+          return true;
+      }
+      return false;
+    }
+
+    PBchordCallback callback; // called when a chord is released
+    unsigned int window; // the buttons of a chord must be pushed within window ms from the first one
+    unsigned long first; // millis() when the first button of the group was pushed
+    uint8_t chords[PB_CHORDS_SIZE]; // the registered chords, sorted
+    uint8_t n; // number of chords registered
+    volatile uint8_t down; // the buttons pushed
+    volatile uint8_t group; // the buttons pushed within the window from the first one
+    volatile uint8_t consumed; // the buttons (still pushed) that made a chord - their callbacks are not called
+};
+#endif
+
+// Adaptive debounce - define PB_ADAPTIVE 1 before including this file and call setAdaptive(minMs, maxMs) on a button:
+// change() then measures the spread of every bounce burst (first to last edge, a burst ends once the pin stays at a
+// level longer than the estimate)
+// and keeps a running estimate of its 95th percentile. The debounce time is set to the estimate + 50%, kept within
+// [minMs, maxMs], so a good switch gets a short debounce and a worn one a longer, as it ages. getUBdelay() returns it.
+#ifndef PB_ADAPTIVE
+#define PB_ADAPTIVE 0
+#endif
+
+// Leading edge mode - define PB_LEADING 1 before including this file to enable PBmonitor::setLeadingEdge()
+// (the lockout adds 8 bytes to every PBmonitor)
+#ifndef PB_LEADING
+#define PB_LEADING 0
+#endif
+
+#if PB_LEADING
+// the leading edge mode of PBmonitor<LOW> and PBmonitor<HIGH> - the same but for the level the button is pushed at
+template <class PB>
+struct PBleading
+{
+  static void start(PB &b, unsigned long lockoutUs)
+  {
+    PBirq irq = PBdisable(); // Save the status, the interrupts off
+    b.lockout = lockoutUs;
+    b.bp.accepted = PB::pushed(b.bp.prevState);
+    b.bp.locked = false;
+    PBrestore(irq);
+  }
+
+  static void expire(PB &b)
+  {
+    if(!b.lockout || !b.bp.monitoring)
+      return;
+    PBirq irq = PBdisable(); // Save the status, the interrupts off
+    unsigned long us = micros();
+    if(!b.bp.locked || us - b.lockStart >= b.lockout)
+    {
+      b.bp.locked = false;
+      b.bp.prevState = (*b.pinReg & b.pinMask) != 0;
+      if((PB::pushed(b.bp.prevState)) != b.bp.accepted)
+        accept(b, PB::pushed(b.bp.prevState), millis(), us, false); // the lockout is over, not a new one
+    }
+    PBrestore(irq);
+  }
+
+  // an edge at us (micros) with the pin at state, bp.prevState holds the level before it
+  static void edge(PB &b, bool state, unsigned long now, unsigned long us)
+  {
+    if(b.bp.locked)
+    {
+      if(us - b.lockStart < b.lockout) // bouncing - ignored
+      {
+        b.bp.prevState = state;
+        PB_STAT(b.stats.rejected++);
+        return;
+      }
+      b.bp.locked = false;
+      if((PB::pushed(b.bp.prevState)) != b.bp.accepted) // the level the lockout ended with was not taken - a transition was missed
+        accept(b, PB::pushed(b.bp.prevState), now, us, false);
+    }
+    b.bp.prevState = state;
+    if((PB::pushed(state)) != b.bp.accepted)
+      accept(b, PB::pushed(state), now, us, true);
+  }
+
+  // takes a transition to pushed (or released), calls the callback if it is the one to react on
+  static void accept(PB &b, bool pushed, unsigned long now, unsigned long us, bool lock)
+  {
+    PBtick tk = PB_TICKS();
+    b.bp.accepted = pushed;
+    if(lock) // ignore the bounces
+    {
+      b.lockStart = us;
+      b.bp.locked = true;
+    }
+    if(pushed)
+      b.pushedAt(now, tk);
+#if PB_CHORDS_SIZE > 0
+    if(b.chords && pushed)
+      b.chords->press(b.chordBit, now);
+    else if(b.chords && b.chords->release(b.chordBit, now))
+      return; // was in a chord
+#endif
+    if(pushed != b.bp.actWhen)
+      return;
+    if(b.bp.inCallback)
+    {
+      PB_STAT(b.stats.dropped++);
+    }
+    else
+      b.invoke(b.report(b.held(now, tk)));
+  }
+};
+#endif
+
+// the parts of PBmonitor<LOW> and PBmonitor<HIGH> that do not depend on the level the button is pushed at -
+// PB is the specialization, PB::pushed(level) tells if the pin at level means pushed
+template <class PB>
+class PBmonitorBase
+{
+  public:
+    ~PBmonitorBase() { stopMonitoring(); }
+
+    void stopMonitoring()
+    {
+      // detachInterrupt(digitalPinToInterrupt(pinPB));
+      PBdetach(pinPB);
+      if(!isr)
+        PBregistry::remove(pinPB);
+      bp.monitoring=false;
+    }
+
+    void change()
+    {
+      PB_STAT(unsigned long t0 = micros());
+      PB_STAT(stats.edges++);
+#if PB_ATOMIC
+      unsigned long now=millis();
+#else
+      PBirq irq = PBenable(); // Save the status, the interrupts on
+      unsigned long now=millis();
+      PBrestore(irq);
+#endif
+      PBtick tk = PB_TICKS(); // (PB_TIMEBASE_MICROS or _TIMER)
+      bool state = (*pinReg & pinMask) != 0;
+#if PB_ADAPTIVE
+      if(adaptMax)
+        learn(micros());
+#endif
+#if PB_TRACE_SIZE > 0
+      if(trace)
+        trace->record(state, micros());
+#endif
+#if PB_LEADING
+      if(lockout) // leading edge mode - takes precedence over the deferred mode
+      {
+        PB_STAT(stats.lastCb = 0);
+        PBleading<PB>::edge(*static_cast<PB *>(this), state, now, micros());
+        PB_STAT(stats.isr(micros() - t0 - stats.lastCb));
+        return;
+      }
+#endif
+#if PB_ATOMIC
+      queue.push(pinPB, state, now, tk);
+      if(!deferred.load(std::memory_order_relaxed)) // process it now, unless another core / task is doing so - then it will
+        drain();
+      return;
+#endif
+#if PB_QUEUE_SIZE > 0
+      if(bp.deferred) // just record the edge, poll() will process it
+      {
+        queue.push(pinPB, state, now, tk);
+        PB_STAT(stats.isr(micros() - t0));
+        return;
+      }
+#endif
+      PB_STAT(stats.lastCb = 0);
+      process(state, now, tk);
+      PB_STAT(stats.isr(micros() - t0 - stats.lastCb));
+    }
+
+#if PB_LEADING
+    // leading edge mode - the callback is called on the very first edge (no debounce delay), then the pin is ignored
+    // for lockoutUs microseconds after every accepted transition, so the bounces can not fire it again.
+    // The lockout must be longer than the bouncing of the contact. 0 turns it off (default)
+    void setLeadingEdge(unsigned long lockoutUs) { PBleading<PB>::start(*static_cast<PB *>(this), lockoutUs); }
+    unsigned long getLeadingEdge() const { return lockout; }
+    // in leading edge mode recovers a transition missed while the pin was ignored (e.g. a release within the lockout)
+    // as soon as the lockout expires, call it from loop() - otherwise it is recovered at the next edge
+    void expire() { PBleading<PB>::expire(*static_cast<PB *>(this)); }
+#endif
+
+#if PB_CHORDS_SIZE > 0
+    // joins the button to chords as button id (0..7) - the bit of the button in the chord masks, 0 = leave
+    void setChords(PBchords *c, uint8_t id = 0) { chords = c; chordBit = 1 << id; }
+    PBchords *getChords() const { return chords; }
+#endif
+
+#if PB_ADAPTIVE
+    // learns the debounce time from the bounces within [minMs, maxMs] starting from the current one, maxMs = 0 stops
+    void setAdaptive(uint8_t minMs, uint8_t maxMs)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      adaptMin = minMs;
+      adaptMax = maxMs;
+      estimate = (getUBdelay() << 11) / 3; // so the debounce time (estimate + 50%) starts where it is
+      burstStart = lastEdge = micros();
+      PBrestore(irq);
+    }
+    unsigned long getEstimate() const { return estimate; } // the 95th percentile of the bounce burst spread in micros
+#endif
+
+#if PB_TRACE_SIZE > 0
+    void setTrace(PBtrace *t) { if(t) t->clear(pinPB, PB::pushed(HIGH), micros()); trace = t; } // log the edges (0 = stop)
+    PBtrace *getTrace() const { return trace; }
+#endif
+
+#if PB_STATS
+    PBstats snapshot() const // consistent copy of the counters
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      PBstats s = stats;
+      PBrestore(irq);
+      return s;
+    }
+    void resetStats() { PBirq irq = PBdisable(); stats.reset(); PBrestore(irq); }
+#endif
+
+#if PB_QUEUE_SIZE > 0
+    // in deferred mode must be called (from loop) to process the recorded edges and run the callbacks
+    void poll()
+    {
+#if PB_ATOMIC
+      drain();
+      if(gesture && !busy.test_and_set(std::memory_order_seq_cst)) // held by another core - it is feeding the gesture
+      {
+        gesture->service(millis());
+        busy.clear(std::memory_order_seq_cst);
+        if(queue.pending()) // the drain() of another core may have given up meanwhile
+          drain();
+      }
+#else
+      PBevent e;
+      while(queue.pop(e))
+        if(gesture)
+          gesture->edge(PB::pushed(e.edge), e.t);
+        else
+          process(e.edge, e.t, e.ticks());
+      if(gesture)
+        gesture->service(millis());
+#endif
+    }
+    // hands the edges to a gesture state machine (instead of the callback), poll() must be called often
+    void setGesture(PBgesture *g) { gesture = g; if(g) setDeferred(true); }
+    PBgesture *getGesture() const { return gesture; }
+#if PB_ATOMIC
+    void setDeferred(bool d) { bp.deferred = d; deferred.store(d); }
+#else
+    void setDeferred(bool d) { bp.deferred = d; }
+#endif
+    bool isDeferred() const { return bp.deferred; }
+    uint8_t getPending() const { return queue.pending(); }
+    unsigned int getOverflows() const { return queue.getOverflows(); } // edges lost because the queue was full
+#endif
+
+  protected:
+    PBmonitorBase(uint8_t pinPBNo, PBanyCallback f, void *ctx, ISR isrv, bool actpr, unsigned long t_i, bool hasCtx) :
+      pinPB(pinPBNo), pinMask(0), pinReg(0), callback(f), isr(isrv), elapsedMils(0), debounceDelay(msToTicks(t_i))
+    {
+#if PB_REGISTRY_SIZE > 0
+      context = ctx;
+#else
+      (void)ctx; // (the context callbacks come with the registry)
+#endif
+      init(actpr, hasCtx);
+    }
+
+    void monitor() // starts monitoring the pin, its mode already set by startMonitoring()
+    {
+      pinReg = portInputRegister(digitalPinToPort(pinPB)); // resolve the port and bit once, so change() needs no digitalRead()
+      pinMask = digitalPinToBitMask(pinPB);
+      bp.prevState = (*pinReg & pinMask) != 0;
+#if PB_LEADING
+      bp.accepted = PB::pushed(bp.prevState);
+      bp.locked = false;
+#endif
+      elapsedMils=0;
+#if PB_TIMEBASE != PB_TIMEBASE_MILLIS
+      elapsedTicks=0;
+#endif
+      bp.monitoring=true;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      // attachInterrupt(digitalPinToInterrupt(pinPB), isr, CHANGE); // set interrupt on change
+      if(isr)
+        PBattach(pinPB, isr, CHANGE);
+      else if(PBregistry::add(pinPB, static_cast<PB *>(this), PBregistry::changeOf<PB>, PBregistry::idleOf<PB>))
+        PBattach(pinPB, PBregistry::isrOf(pinPB), CHANGE);
+      else // no room in the registry
+        bp.monitoring=false;
+      PBrestore(irq);
+    }
+
+    void init(bool actpr, bool ctx)
+    {
+      bp.actWhen = actpr;
+      bp.inCallback = false;
+      bp.hasContext = ctx;
+      bp.deferred = false;
+#if PB_LEADING
+      bp.accepted = false;
+      bp.locked = false;
+      lockout = 0;
+      lockStart = 0;
+#endif
+#if PB_ADAPTIVE
+      adaptMin = adaptMax = 0;
+#endif
+#if PB_CHORDS_SIZE > 0
+      chords = 0;
+      chordBit = 0;
+      releasedMils = 0;
+#endif
+#if PB_QUEUE_SIZE > 0
+      gesture = 0;
+#endif
+#if PB_ATOMIC
+      busy.clear();
+      deferred.store(false);
+#endif
+#if PB_TRACE_SIZE > 0
+      trace = 0;
+#endif
+      bp.prevState = !PB::pushed(HIGH); // released
+      bp.monitoring = false;
+    }
+
+    void process(bool state, unsigned long now, PBtick tk)
+    {
+      bool pushRegistered=false;
+      bool pushed = !PB::pushed(bp.prevState) && PB::pushed(state);
+      bool released = PB::pushed(bp.prevState) && !PB::pushed(state);
+
+      if(pushed)
+      {
+          pushedAt(now, tk); // just store the time when pushed down
+          pushRegistered = bp.actWhen;
+      }
+      else if(released) // take action now
+          pushRegistered = !bp.actWhen;
+
+#if PB_CHORDS_SIZE > 0
+      if(chords && pushed && now - releasedMils > getUBdelay()) // not a bounce of the release
+        chords->press(chordBit, now);
+      else if(chords && released) // every release leaves pressed(), only the settled ones decide a chord
+      {
+        bool decide = settled(now, tk);
+        if(decide)
+          releasedMils = now;
+        if(chords->release(chordBit, now, decide))
+          pushRegistered = false; // was in a chord
+      }
+#endif
+      bp.prevState=state;
+#if PB_STATS
+      if(pushRegistered && !(bp.actWhen || settled(now, tk)))
+        stats.rejected++;
+      else if(pushRegistered && bp.inCallback)
+        stats.dropped++;
+#endif
+      if(pushRegistered && (bp.actWhen || settled(now, tk)) && !bp.inCallback) // was pressed long enought and not servicing previous press
+        invoke(report(held(now, tk)));
+    }
+
+    void pushedAt(unsigned long now, PBtick tk) // stores the time pushed down
+    {
+      elapsedMils = now;
+#if PB_TIMEBASE != PB_TIMEBASE_MILLIS
+      elapsedTicks = tk;
+#else
+      (void)tk; // (not used with millis())
+#endif
+    }
+    unsigned long held(unsigned long now, PBtick tk) const // the time since pushed down in ticks of the timebase
+    {
+#if PB_TIMEBASE == PB_TIMEBASE_MILLIS
+      (void)tk; // (not used with millis())
+      return now - elapsedMils;
+#else
+      // millis() tells the ticks within a ms or two, the 16 bit counter exactly - but only modulo 65536
+      unsigned long ms = now - elapsedMils;
+      if(ms >= PB_HELD_MAX_MS) // saturates rather than wraps
+        return PB_HELD_MAX_MS * PB_TICKS_PER_MS;
+      unsigned long coarse = ms * PB_TICKS_PER_MS;
+      return coarse + (int16_t)(PBtick)(tk - elapsedTicks - (PBtick)coarse);
+#endif
+    }
+    bool settled(unsigned long now, PBtick tk) const { return held(now, tk) > debounceDelay; } // pushed longer than the debounce time
+    static unsigned long report(unsigned long ticks) // the time held as passed to the callback (ms or us)
+    {
+#if PB_TIMEBASE == PB_TIMEBASE_TIMER
+      return ticks / PB_TICKS_PER_MS * 1000 + ticks % PB_TICKS_PER_MS * 1000 / PB_TICKS_PER_MS;
+#else
+      return ticks;
+#endif
+    }
+    static unsigned long msToTicks(unsigned long ms)
+    {
+#if PB_TIMEBASE == PB_TIMEBASE_MILLIS
+      return ms;
+#else
+      return (ms < PB_UBDELAY_MAX_MS ? ms : PB_UBDELAY_MAX_MS) * PB_TICKS_PER_MS; // the constructors and setAdaptive() clamp
+#endif
+    }
+
+#if PB_ADAPTIVE
+    void learn(unsigned long us) // an edge at us (micros) - measures the bounce bursts and adapts debounceDelay
+    {
+      // a level held longer than the bursts usually last is not a bounce, so the burst is over - a press (even one
+      // shorter than maxMs) is not taken for a burst with the bounces of its release
+      unsigned long window = estimate;
+      if(window < (unsigned long)(adaptMin ? adaptMin : 1) << 10)
+        window = (unsigned long)(adaptMin ? adaptMin : 1) << 10;
+      if(us - lastEdge > window)
+      {
+        unsigned long spread = lastEdge - burstStart;
+        unsigned long step = (estimate >> 6) + 1;
+        if(spread > estimate) // steps up 19 times larger than down - settles where 1 in 20 bursts is longer
+          estimate += 19 * step;
+        else if(spread < estimate)
+          estimate -= step;
+        if(estimate > (unsigned long)adaptMax << 10)
+          estimate = (unsigned long)adaptMax << 10;
+        unsigned long d = (estimate + (estimate >> 1) + 1023) >> 10; // + 50%, in ms (of 1024us - no division in the ISR)
+        debounceDelay = msToTicks(d < adaptMin ? adaptMin : d > adaptMax ? adaptMax : d);
+        burstStart = us;
+      }
+      lastEdge = us;
+    }
+#endif
+
+    void invoke(unsigned long n) // calls the callback (with the interrupts enabled)
+    {
+      bp.inCallback=true;
+#if !PB_ATOMIC
+      PBirq irq = PBenable(); // Save the status, the interrupts on
+#endif
+      PB_STAT(unsigned long tc = micros());
+#if PB_REGISTRY_SIZE > 0
+      if(bp.hasContext)
+        callback.withContext(context, n);
+      else
+#endif
+        callback.plain(n);
+      PB_STAT(stats.callback(micros() - tc));
+#if !PB_ATOMIC
+      PBrestore(irq);
+#endif
+      bp.inCallback=false;
+    }
+
+#if PB_ATOMIC
+    // processes the queued edges - one core / task at a time, the others do not wait, they leave them to it
+    void drain()
+    {
+      do
+      {
+        if(busy.test_and_set(std::memory_order_seq_cst)) // being processed - the owner sees the new edges
+          return;
+        PBevent e;
+        while(queue.pop(e))
+          if(gesture)
+            gesture->edge(PB::pushed(e.edge), e.t);
+          else
+            process(e.edge, e.t, e.ticks());
+        busy.clear(std::memory_order_seq_cst);
+      } while(queue.pending()); // pushed after the last pop, before the release - its drain() may have given up
+    }
+#endif
+
+  public:
+    // if not used you can comment out this functions
+    bool isMonitoring() const { return bp.monitoring; } // is monitored = ISR installed
+    // in ms (adapted further while setAdaptive() is on) - up to PB_UBDELAY_MAX_MS (65ms with PB_TIMEBASE_MICROS),
+    // returns false and keeps the debounce time if t is longer
+    bool setUBdelay(unsigned long t)
+    {
+      if(t > PB_UBDELAY_MAX_MS)
+        return false;
+      debounceDelay = msToTicks(t);
+      return true;
+    }
+#if PB_TIMEBASE == PB_TIMEBASE_MILLIS
+    unsigned long getUBdelay(void) const { return debounceDelay; }
+#else
+    unsigned long getUBdelay(void) const { return debounceDelay / PB_TICKS_PER_MS; }
+#endif
+    bool isInCallback() const { return bp.inCallback; }
+    bool isIdle() const // released and nothing pending (in the callback, queued, timing) - PBpower may sleep deeply
+    {
+      if(PB::pushed(bp.prevState) || bp.inCallback)
+        return false;
+#if PB_LEADING
+      if(lockout && bp.locked)
+        return false;
+#endif
+#if PB_QUEUE_SIZE > 0
+      if(queue.pending() || (gesture && !gesture->isIdle()))
+        return false;
+#endif
+      return true;
+    }
+    void setCallback(PBcallback f) { callback.plain=f; bp.hasContext=false; }
+    PBcallback getCallback() const { return bp.hasContext ? 0 : callback.plain; } // 0 if set with a context
+#if PB_REGISTRY_SIZE > 0
+    void setCallback(PBcallbackCtx f, void *ctx) { callback.withContext=f; context=ctx; bp.hasContext=true; }
+    void *getContext() const { return context; }
+    PBcallbackCtx getCallbackCtx() const { return bp.hasContext ? callback.withContext : 0; } // 0 if set without
+#endif
+
+  protected:
+    uint8_t pinPB; // pinPB at which change of level is monitored
+    PBportMask pinMask; // bit of pinPB in its port input register
+    PBportReg *pinReg; // input register of the port pinPB belongs to
+    PBanyCallback callback; // pointer to function to be called when button is pressed
+#if PB_REGISTRY_SIZE > 0
+    void *context; // passed to the callback (if set with a context)
+#endif
+    ISR isr; // pointer to void f() function to serve as interrupt service routine - must be defined on a global scope
+#if PB_TIMEBASE == PB_TIMEBASE_MILLIS
+    unsigned long elapsedMils; // elapsed millis since the last call to ISR
+    unsigned long debounceDelay; // time to be ignorred - changes that appear @ t < debounceDelay will be ignored
+#else
+    unsigned long elapsedMils; // millis() when pushed down - counts the wraps of elapsedTicks
+    PBtick elapsedTicks; // the timebase counter when pushed down
+    PBtick debounceDelay; // in ticks of the timebase - changes that appear @ t < debounceDelay will be ignored
+#endif
+#if PB_LEADING
+    unsigned long lockout; // leading edge mode: micros the pin is ignored after a transition (0 = off)
+    unsigned long lockStart; // leading edge mode: micros() of the last transition taken
+    friend struct PBleading<PB>;
+#endif
+    struct bitPack // saves space packing all bool data memebers in single bute
+    {
+      uint8_t actWhen:1; // when to react (call the callbak) on press (true) or on release (false)
+      uint8_t inCallback:1; // true while executing the callback function, will not re-enter the function from the same interrupt (isr disabled)
+      uint8_t prevState:1; // previous state of the pinPB (checked in the ISR)
+      uint8_t monitoring:1; // is active and monitoring the push button
+      uint8_t deferred:1; // edges are queued by change() and processed by poll()
+      uint8_t hasContext:1; // callback is a PBcallbackCtx
+      uint8_t accepted:1; // leading edge mode: the button is taken as pushed
+      uint8_t locked:1; // leading edge mode: ignoring the pin (within the lockout)
+    } bp;
+#if PB_QUEUE_SIZE > 0
+    PBeventQueue<PB_QUEUE_SIZE> queue; // edges recorded in deferred mode waiting to be processed
+    PBgesture *gesture; // gesture state machine fed by poll() (if any)
+#endif
+#if PB_ATOMIC
+    std::atomic_flag busy; // the queued edges are being processed
+    std::atomic<bool> deferred; // bp.deferred for change() - the bits of bp are written by whoever processes the edges
+#endif
+#if PB_CHORDS_SIZE > 0
+    PBchords *chords; // the chords the button is in (if any)
+    uint8_t chordBit; // the bit of the button in the chord masks
+    unsigned long releasedMils; // millis() of the last release (the bounces after it are not presses)
+#endif
+#if PB_ADAPTIVE
+    unsigned long burstStart; // micros() of the first edge of the current bounce burst
+    unsigned long lastEdge; // micros() of the last edge
+    unsigned long estimate; // the 95th percentile of the burst spread in micros
+    uint8_t adaptMin; // bounds of the adapted debounceDelay in ms (adaptMax = 0 - not adapting)
+    uint8_t adaptMax;
+#endif
+#if PB_STATS
+    PBstats stats; // counters (instrumentation)
+#endif
+#if PB_TRACE_SIZE > 0
+    PBtrace *trace; // edge log (if any)
+#endif
+};
+
+// .. note - using <type_traits> would be more elegant (shorter source) but ... it generates larger code
+template <bool ACTIVE = false>
+class PBmonitor { }; // the class represnting a push button to be monitored using interrupts
+
+// the class specialization for a active low push button (connects pinPB to GND)
+// since this (the way the button is connected) is not going to change in a sketch 
+template <>
+class PBmonitor<LOW> : public PBmonitorBase<PBmonitor<LOW> >
+{
+  public:
+    PBmonitor(uint8_t pinPBNo, PBcallback f, ISR isrv, bool actpr = ONRELEASE, unsigned long t_i = 20) :
+      PBmonitorBase<PBmonitor>(pinPBNo, f, 0, isrv, actpr, t_i, false) { }
+#if PB_REGISTRY_SIZE > 0
+    // served by the shared ISR of PBregistry - no ISR wrapper function needed
+    PBmonitor(uint8_t pinPBNo, PBcallback f, bool actpr = ONRELEASE, unsigned long t_i = 20) :
+      PBmonitorBase<PBmonitor>(pinPBNo, f, 0, 0, actpr, t_i, false) { }
+    // callback with a user context, served by the shared ISR
+    PBmonitor(uint8_t pinPBNo, PBcallbackCtx f, void *ctx, bool actpr = ONRELEASE, unsigned long t_i = 20) :
+      PBmonitorBase<PBmonitor>(pinPBNo, f, ctx, 0, actpr, t_i, true) { }
+#endif
+    void startMonitoring()
+    {
+      digitalWrite(pinPB, HIGH);
+      pinMode(pinPB, INPUT_PULLUP);
+      monitor();
+    }
+
+    // if not used you can comment out this functions
+    bool type() const { return LOW; }
+    static bool pushed(bool level) { return level == LOW; } // only this part actually differs in the specialization
+};
+
+template <>
+class PBmonitor<HIGH> : public PBmonitorBase<PBmonitor<HIGH> > // the class specialization for a active high push button (connects pinPB to Vcc)
+{
+  public:
+    PBmonitor(uint8_t pinPBNo, PBcallback f, ISR isrv, bool actpr = ONRELEASE, unsigned long t_i = 20) :
+      PBmonitorBase<PBmonitor>(pinPBNo, f, 0, isrv, actpr, t_i, false) { }
+#if PB_REGISTRY_SIZE > 0
+    // served by the shared ISR of PBregistry - no ISR wrapper function needed
+    PBmonitor(uint8_t pinPBNo, PBcallback f, bool actpr = ONRELEASE, unsigned long t_i = 20) :
+      PBmonitorBase<PBmonitor>(pinPBNo, f, 0, 0, actpr, t_i, false) { }
+    // callback with a user context, served by the shared ISR
+    PBmonitor(uint8_t pinPBNo, PBcallbackCtx f, void *ctx, bool actpr = ONRELEASE, unsigned long t_i = 20) :
+      PBmonitorBase<PBmonitor>(pinPBNo, f, ctx, 0, actpr, t_i, true) { }
+#endif
+    void startMonitoring()
+    {
+      digitalWrite(pinPB, LOW);
+      pinMode(pinPB, INPUT); // pulldown resistor needed
+      monitor();
+    }
+
+    // if not used you can comment out this functions
+    bool type() const { return HIGH; }
+    static bool pushed(bool level) { return level == HIGH; } // only this part actually differs in the specialization
+};
+
+// Quadrature rotary encoder - the A and B pins are monitored by CHANGE interrupts (own ISR or the shared one of
+// PBregistry). change() reads both pins directly from the port registers and decodes the transition of the 2 bit state
+// with a table: +1 / -1 for a valid step, none if nothing changed, an error if both bits changed (an edge was missed).
+// There is no millis() and no SREG juggling in it, so it keeps up with an encoder turned fast. The position is read
+// lock-free from loop() by getPosition(), update() (called from loop) computes the velocity and the acceleration.
+// countsPerStep is the number of transitions per detent (4 for most encoders, 2 or 1).
+class PBencoder
+{
+  public:
+    PBencoder(uint8_t pinANo, uint8_t pinBNo, ISR isrv, uint8_t countsPerStep = 4) : pinA(pinANo), pinB(pinBNo), isr(isrv)
+    {
+      init(countsPerStep);
+    }
+#if PB_REGISTRY_SIZE > 0
+    // served by the shared ISR of PBregistry (takes 2 entries of it)
+    PBencoder(uint8_t pinANo, uint8_t pinBNo, uint8_t countsPerStep = 4) : pinA(pinANo), pinB(pinBNo), isr(0)
+    {
+      init(countsPerStep);
+    }
+#endif
+    ~PBencoder() { stopMonitoring(); }
+
+    bool startMonitoring() // returns false if there is no room in the registry
+    {
+      if(!isr && !(PBregistry::add(pinA, this, PBregistry::changeOf<PBencoder>) && PBregistry::add(pinB, this, PBregistry::changeOf<PBencoder>)))
+      {
+        PBregistry::remove(pinA);
+        return false;
+      }
+      digitalWrite(pinA, HIGH);
+      pinMode(pinA, INPUT_PULLUP);
+      digitalWrite(pinB, HIGH);
+      pinMode(pinB, INPUT_PULLUP);
+      regA = portInputRegister(digitalPinToPort(pinA));
+      maskA = digitalPinToBitMask(pinA);
+      regB = portInputRegister(digitalPinToPort(pinB));
+      maskB = digitalPinToBitMask(pinB);
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      state = read();
+      PBattach(pinA, isr ? isr : PBregistry::isrOf(pinA), CHANGE);
+      PBattach(pinB, isr ? isr : PBregistry::isrOf(pinB), CHANGE);
+      monitoring = true;
+      PBrestore(irq);
+      return true;
+    }
+
+    void stopMonitoring()
+    {
+      PBdetach(pinA);
+      PBdetach(pinB);
+      if(!isr)
+      {
+        PBregistry::remove(pinA);
+        PBregistry::remove(pinB);
+      }
+      monitoring = false;
+    }
+
+    void change() // the ISR
+    {
+      // index: previous AB, new AB - the Gray code sequence 00 01 11 10 counts up, 2 = invalid (both changed)
+      static const int8_t steps[16] = { 0, 1, -1, 2,  -1, 0, 2, 1,  1, 2, 0, -1,  2, -1, 1, 0 };
+      uint8_t ab = read();
+      int8_t d = steps[(state << 2) | ab];
+      state = ab;
+      if(d == 2)
+        errors++;
+      else
+        count += d;
+    }
+
+    long getCount() const // transitions counted, read without disabling the interrupts
+    {
+      long a, b;
+      do // read until two reads agree - not torn by the ISR
+      {
+        a = count;
+        b = count;
+      } while(a != b);
+      return a;
+    }
+    long getPosition() const { return getCount() >> shift; } // in steps (detents)
+    void setPosition(long p)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      count = p << shift;
+      PBrestore(irq);
+    }
+    unsigned int getErrors() const // invalid transitions seen (edges missed)
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      unsigned int e = errors;
+      PBrestore(irq);
+      return e;
+    }
+
+    // computes the velocity and the acceleration every intervalMs, call it from loop(), returns true if they were updated
+    bool update(unsigned int intervalMs = 20)
+    {
+      unsigned long now = millis();
+      unsigned long dt = now - lastTime;
+      if(dt < intervalMs)
+        return false;
+      long c = getCount();
+      long v = (c - lastCount) * 1000L / (long)dt;
+      accel = (v - velocity) * 1000L / (long)dt;
+      velocity = v;
+      lastCount = c;
+      lastTime = now;
+      return true;
+    }
+    long getVelocity() const { return velocity / (1 << shift); } // steps per second (signed)
+    long getAcceleration() const { return accel / (1 << shift); } // steps per second per second
+
+    // if not used you can comment out this functions 
+    bool isMonitoring() const { return monitoring; }
+
+  private:
+    void init(uint8_t countsPerStep)
+    {
+      shift = countsPerStep >= 4 ? 2 : countsPerStep >= 2 ? 1 : 0;
+      regA = regB = 0;
+      maskA = maskB = 0;
+      state = 0;
+      count = 0;
+      errors = 0;
+      lastCount = 0;
+      lastTime = 0;
+      velocity = accel = 0;
+      monitoring = false;
+    }
+    uint8_t read() const { return ((*regA & maskA) ? 2 : 0) | ((*regB & maskB) ? 1 : 0); } // the AB state
+
+    uint8_t pinA, pinB; // the pins of the A and B outputs
+    PBportReg *regA, *regB; // input registers of the ports of pinA and pinB
+    PBportMask maskA, maskB; // bits of pinA and pinB in them
+    ISR isr; // the ISR of both pins (0 - the shared ISR of PBregistry)
+    volatile long count; // transitions counted
+    volatile unsigned int errors; // invalid transitions
+    uint8_t state; // last AB state
+    uint8_t shift; // log2 of the transitions per step
+    bool monitoring; // the ISRs are installed
+    long lastCount; // count at the last update()
+    unsigned long lastTime; // millis() of the last update()
+    long velocity; // transitions per second
+    long accel; // transitions per second per second
+};
+
+// Cooperative scheduler - lets the button callbacks start long actions (LED sequences, actuators...) that run
+// from loop() instead of blocking in the callback with delay(). A task is a step function, called with its context
+// and its step counter (kept by the scheduler, 0 on the first call), that does one step of the work and returns
+// the time in ms until it should be called again, or PB_TASK_DONE when finished. No heap is used, the task table
+// has a fixed size. start() can be called from a callback (interrupt), run() must be called from loop() often.
+// With PB_ATOMIC start() must be called on one core only.
+#define PB_TASK_DONE 0xFFFFFFFFUL
+
+typedef unsigned long (*PBtaskStep) (void *, uint8_t &); // pointer to a step function (context, step counter)
+
+template <uint8_t N = 4>
+class PBscheduler
+{
+  public:
+    PBscheduler()
+    {
+      for(uint8_t i=0; i<N; i++)
+      {
+        tasks[i].step = 0;
+        tasks[i].gen = 0;
+      }
+    }
+
+    // starts (or restarts, if already running with the same context) a task after delayMs, returns its id or -1 if the table is full
+    int8_t start(PBtaskStep f, void *ctx = 0, unsigned long delayMs = 0)
+    {
+      int8_t id = -1;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      for(uint8_t i=0; i<N; i++)
+        if(tasks[i].step == f && tasks[i].ctx == ctx)
+        {
+          id = i;
+          break;
+        }
+        else if(!tasks[i].step && id < 0)
+          id = i;
+      if(id >= 0)
+      {
+        Task &t = tasks[id];
+        t.ctx = ctx;
+        t.state = 0;
+        t.wake = millis() + delayMs;
+        t.step = f;
+        t.gen++;
+      }
+      PBrestore(irq);
+      return id;
+    }
 
+    void stop(int8_t id)
+    {
+      if(id < 0 || id >= N)
+        return;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      tasks[id].step = 0;
+      PBrestore(irq);
+    }
+    bool isRunning(int8_t id) const { return id >= 0 && id < N && tasks[id].step; }
+    bool isRunning(PBtaskStep f, void *ctx = 0) const
+    {
+      for(uint8_t i=0; i<N; i++)
+        if(tasks[i].step == f && tasks[i].ctx == ctx)
+          return true;
+      return false;
+    }
+    bool isIdle() const // no task running
+    {
+      for(uint8_t i=0; i<N; i++)
+        if(tasks[i].step)
+          return false;
+      return true;
+    }
 
-// Macros to automate Push button object instatiation with interrupt service routine global function definition 
-// Interrupts needs a void function (not part of the class) to act as interrupt service routine that must be defined outside the class 
-// as a wrapper to member function to be called on button change state (from the interrupt)
-#define SET_PB(PBUTTON, PIN_BUT, FP_CALLB, FP_ISR, TYPE, POR, T_IGNORE) PBmonitor<TYPE> PBUTTON(PIN_BUT, FP_CALLB, PBUTTON##_ISR, POR, T_IGNORE); \
-void PBUTTON##_ISR() { PBUTTON.change(); }
-#define PUSH_BUTTON_L(PBUTTON, PIN_BUT, FP_CALLB, POR) PBmonitor<false> PBUTTON(PIN_BUT, FP_CALLB, PBUTTON##_ISR, POR); \
-void PBUTTON##_ISR() { PBUTTON.change(); }
-#define PUSH_BUTTON_H(PBUTTON, PIN_BUT, FP_CALLB, POR) PBmonitor<true> PBUTTON(PIN_BUT, FP_CALLB, PBUTTON##_ISR, POR); \
-void PBUTTON##_ISR() { PBUTTON.change(); }
+    // calls the step functions of the tasks due, call it from loop()
+    void run()
+    {
+      for(uint8_t i=0; i<N; i++)
+      {
+        PBirq irq = PBdisable(); // Save the status, the interrupts off
+        Task t = tasks[i];
+        PBrestore(irq);
+        unsigned long now = millis();
+        if(!t.step || (long)(now - t.wake) < 0)
+          continue;
+        unsigned long next = t.step(t.ctx, t.state);
+        irq = PBdisable();
+        if(tasks[i].step == t.step && tasks[i].gen == t.gen) // not stopped or restarted meanwhile
+        {
+          tasks[i].state = t.state;
+          tasks[i].wake = now + next;
+          if(next == PB_TASK_DONE)
+            tasks[i].step = 0;
+        }
+        PBrestore(irq);
+      }
+    }
 
-typedef void (*ISR)(); // pointer to void function (to act as interrupt service routine)
-typedef void (*PBcallback) (unsigned long); // pointer to void function taking one int (should be unsigned long) 
-// to be called from the push button monitor object when the button wil be released passing the number od miliseconds the button was held down
+    // ms until the next task is due (0 = now), PB_TASK_DONE if there is none
+    unsigned long nextWake() const
+    {
+      unsigned long now = millis(), next = PB_TASK_DONE;
+      for(uint8_t i=0; i<N; i++)
+        if(tasks[i].step)
+        {
+          long d = (long)(tasks[i].wake - now);
+          if(d <= 0)
+            return 0;
+          if((unsigned long)d < next)
+            next = d;
+        }
+      return next;
+    }
 
-#define ONRELEASE false
-#define ONPRESS   true
+  private:
+    struct Task
+    {
+      PBtaskStep step; // step function (0 = free)
+      void *ctx; // passed to the step function
+      unsigned long wake; // millis() when to call it next
+      uint8_t state; // step counter
+      uint8_t gen; // incremented on every (re)start
+    };
+    Task tasks[N]; // accessed with interrupts disabled where start() (from an interrupt) could interfere
+};
 
-// .. note - using <type_traits> would be more elegant (shorter source) but ... it generates larger code
-template <bool ACTIVE = false>
-class PBmonitor { }; // the class represnting a push button to be monitored using interrupts
+// Compile time pin - the port input register and the bit of the pin are constants where the pin map is known
+// (ATmega168/328 - Uno, Nano, Pro Mini), so reading a pin is a single instruction. Elsewhere the core's tables are used.
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+template <uint8_t PIN>
+struct PBpin
+{
+  static_assert(PIN < 20, "no such pin");
+  static bool read() { return ((PIN < 8 ? PIND : PIN < 14 ? PINB : PINC) & (1 << (PIN < 8 ? PIN : PIN < 14 ? PIN - 8 : PIN - 14))) != 0; }
+};
+#else
+template <uint8_t PIN>
+struct PBpin
+{
+  static bool read() { return (*portInputRegister(digitalPinToPort(PIN)) & digitalPinToBitMask(PIN)) != 0; }
+};
+#endif
 
-// the class specialization for a active low push button (connects pinPB to GND)
-// since this (the way the button is connected) is not going to change in a sketch 
-template <>
-class PBmonitor<LOW> 
+template <bool B> struct PBtag { }; // selects overloads at compile time
+
+// Push button with everything known at compile time - pin, type (active LOW/HIGH), when to react and the debounce time
+// The state is kept in static members (one set per pin) so there is no per object storage, no ISR wrapper is needed
+// (change() is static and installed directly) and the fields that are not needed are not there at all:
+// the time of the press is not kept for buttons that react on press. Type and edge are resolved by the compiler.
+//   PBmonitorStatic<3, LOW, ONRELEASE, 20> button1(FlashLeds);
+template <uint8_t PIN, bool ACTIVE = LOW, bool EDGE = ONRELEASE, uint16_t DEBOUNCE_MS = 20>
+class PBmonitorStatic
+{
+  public:
+    PBmonitorStatic(PBcallback f) { callback = f; }
+    ~PBmonitorStatic() { stopMonitoring(); }
+    static void startMonitoring() 
+    { 
+      digitalWrite(PIN, ACTIVE ? LOW : HIGH); 
+      pinMode(PIN, ACTIVE ? INPUT : INPUT_PULLUP); // pulldown resistor needed for active high buttons
+      flags = pushed() ? PREV | MONITORING : MONITORING;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      PBattach(PIN, change, CHANGE);
+      PBrestore(irq);
+    }
+
+    static void stopMonitoring() 
+    { 
+      PBdetach(PIN);
+      flags &= ~MONITORING; 
+    }
+
+    static void change() // the ISR
+    { 
+      bool now = pushed();
+      if(now == ((flags & PREV) != 0))
+        return;
+      flags ^= PREV;
+      edge(now, PBtag<EDGE>());
+    }
+
+    // if not used you can comment out this functions 
+    static bool type() { return ACTIVE; }
+    static bool isMonitoring() { return flags & MONITORING; }
+    static unsigned long getUBdelay(void) { return DEBOUNCE_MS; }
+    static bool isInCallback() { return flags & INCALLBACK; }
+    static void setCallback(PBcallback f) { callback = f; }
+    static PBcallback getCallback() { return callback; }
+    static size_t staticSize() { return sizeof(callback) + sizeof(flags) + (EDGE ? 0 : sizeof(unsigned long)); } // RAM used (all of it static)
+
+  private:
+    static bool pushed() { return PBpin<PIN>::read() ^ !ACTIVE; } // compile time XOR with the type of the button
+    static void edge(bool now, PBtag<ONPRESS>) // reacting on press - no timing needed
+    {
+      if(now)
+        fire(0);
+    }
+    static void edge(bool now, PBtag<ONRELEASE>)
+    {
+      PBirq irq = PBenable(); // Save the status, the interrupts on
+      unsigned long t = millis();
+      PBrestore(irq);
+      if(now)
+        elapsedMils = t; // just store the time when pushed down
+      else if(t - elapsedMils > DEBOUNCE_MS) // released after being pressed long enought
+        fire(t - elapsedMils);
+    }
+    static void fire(unsigned long held)
+    {
+      if(flags & INCALLBACK) // servicing previous press
+        return;
+      flags |= INCALLBACK;
+      PBirq irq = PBenable(); // Save the status, the interrupts on
+      callback(held);
+      PBrestore(irq);
+      flags &= ~INCALLBACK;
+    }
+
+    enum { PREV = 1, INCALLBACK = 2, MONITORING = 4 }; // bits in flags
+    static PBcallback callback; // function to be called when the button is pressed
+    static unsigned long elapsedMils; // time the button was pushed down (instantiated only for ONRELEASE)
+    static volatile uint8_t flags; // previous state (1 = pushed), in callback, monitoring
+};
+
+template <uint8_t PIN, bool ACTIVE, bool EDGE, uint16_t DEBOUNCE_MS> PBcallback PBmonitorStatic<PIN, ACTIVE, EDGE, DEBOUNCE_MS>::callback = 0;
+template <uint8_t PIN, bool ACTIVE, bool EDGE, uint16_t DEBOUNCE_MS> unsigned long PBmonitorStatic<PIN, ACTIVE, EDGE, DEBOUNCE_MS>::elapsedMils = 0;
+template <uint8_t PIN, bool ACTIVE, bool EDGE, uint16_t DEBOUNCE_MS> volatile uint8_t PBmonitorStatic<PIN, ACTIVE, EDGE, DEBOUNCE_MS>::flags = 0;
+
+// Bank of up to 8 (32 on 32 bit ports) push buttons of the same type connected to pins of the SAME port
+// All the buttons share a single ISR: on every interrupt the whole port input register is read once, compared (XOR)
+// with the previous snapshot to find all the buttons that changed, and the press/release edges of all of them are 
+// found with bitwise operations - only the buttons that actually changed are visited to check the debounce time.
+// The callbacks behave as in PBmonitor (on press or on release reporting the duration the button was held down),
+// a button is not re-entered while its own callback is executing, but can interrupt the callbacks of other buttons
+template <uint8_t N, bool ACTIVE = LOW>
+class PBmonitorBank
 {
+  static_assert(N > 0 && N <= sizeof(PBportMask) * 8, "too many buttons for a single port");
   public:
-    PBmonitor(uint8_t pinPBNo, PBcallback f, ISR isrv, bool actpr = ONRELEASE, unsigned long t_i = 20) : 
-      pinPB(pinPBNo), callback(f), isr(isrv), debounceDelay(t_i), elapsedMils(0) 
+    PBmonitorBank(const uint8_t *pinPBNo, const PBcallback *f, ISR isrv, bool actpr = ONRELEASE, unsigned long t_i = 20) : 
+      isr(isrv), debounceDelay(t_i), pinReg(0), usedMask(0), snapshot(0), inCallback(0)
     { 
+      for(uint8_t i=0; i<N; i++)
+      {
+        pinPB[i] = pinPBNo[i];
+        callback[i] = f[i];
+        pinMask[i] = 0;
+        elapsedMils[i] = 0;
+      }
       bp.actWhen = actpr;
-      bp.inCallback = false;
-      bp.prevState = HIGH;
       bp.monitoring = false;
     }
-    ~PBmonitor() { stopMonitoring(); }
-    void startMonitoring() 
+    ~PBmonitorBank() { stopMonitoring(); }
+
+    // returns false (and does not start) if the pins are not all on the same port
+    bool startMonitoring() 
     { 
-      digitalWrite(pinPB, HIGH); 
-      pinMode(pinPB, INPUT_PULLUP); 
-      bp.prevState = digitalRead(pinPB);
-      elapsedMils=0;
-      bp.monitoring=true;
-      uint8_t oldSREG = SREG; // Save the status
-      noInterrupts();
-      // attachInterrupt(digitalPinToInterrupt(pinPB), isr, CHANGE); // set interrupt on change
-      enableInterrupt( pinPB, isr, CHANGE);
-      SREG = oldSREG;
+      uint8_t port = digitalPinToPort(pinPB[0]);
+      for(uint8_t i=1; i<N; i++)
+        if(digitalPinToPort(pinPB[i]) != port)
+          return false;
+      pinReg = portInputRegister(port);
+      usedMask = 0;
+      for(uint8_t i=0; i<N; i++)
+      {
+        digitalWrite(pinPB[i], ACTIVE ? LOW : HIGH); 
+        pinMode(pinPB[i], ACTIVE ? INPUT : INPUT_PULLUP); // pulldown resistor needed for active high buttons
+        pinMask[i] = digitalPinToBitMask(pinPB[i]);
+        usedMask |= pinMask[i];
+        elapsedMils[i] = 0;
+      }
+      snapshot = *pinReg & usedMask;
+      inCallback = 0;
+      bp.monitoring = true;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      for(uint8_t i=0; i<N; i++)
+        PBattach(pinPB[i], isr, CHANGE); // the same ISR for all the pins
+      PBrestore(irq);
+      return true;
     }
 
     void stopMonitoring() 
     { 
-      // detachInterrupt(digitalPinToInterrupt(pinPB)); 
-      disableInterrupt(pinPB);
-      bp.monitoring=false; 
+      for(uint8_t i=0; i<N; i++)
+        PBdetach(pinPB[i]);
+      bp.monitoring = false; 
     }
-        
+
     void change() 
     { 
-      bool pushRegistered=false;
-      uint8_t oldSREG = SREG; // Save the status
-      interrupts();
-      unsigned long now=millis();
-      SREG = oldSREG;
-      bool state = digitalRead(pinPB);
-      
-      // only this part actually differs in the specialization ...
-      if(bp.prevState == HIGH && state == LOW)
+      PBportMask state = *pinReg & usedMask; // all the buttons in a single read
+      PBportMask changed = state ^ snapshot;
+      if(!changed) // nothing new (the ISR is invoked once for each of the pins that changed at the same time)
+        return;
+      snapshot = state;
+
+      PBirq irq = PBenable(); // Save the status, the interrupts on
+      unsigned long now = millis();
+      PBrestore(irq);
+
+      PBportMask pressed = ACTIVE ? state : ~state; // buttons held down
+      PBportMask down = changed & pressed; // just pushed
+      PBportMask up = changed & ~pressed; // just released
+      PBportMask fire = 0;
+      for(uint8_t i=0; i<N; i++)
       {
-          elapsedMils = now; // just store the time when pushed down
-          pushRegistered = bp.actWhen;
+        PBportMask m = pinMask[i];
+        if(down & m)
+        {
+          elapsedMils[i] = now; // just store the time when pushed down
+          if(bp.actWhen)
+            fire |= m;
+        }
+        else if((up & m) && !bp.actWhen && now - elapsedMils[i] > debounceDelay) // was pressed long enough
+          fire |= m;
       }
-      else if(bp.prevState == LOW && state == HIGH) // released - take action now
-          pushRegistered = !bp.actWhen;
-      // differ ends
-      
-      bp.prevState=state;
-      if(pushRegistered && (bp.actWhen || now - elapsedMils > debounceDelay) && !bp.inCallback) // was pressed long enought and not servicing previous press
+      fire &= ~inCallback; // not servicing previous press of the same button
+
+      // the callbacks run with the interrupts enabled - a nested change() may store new press times meanwhile,
+      // so the durations are taken now and all the buttons waiting for their turn are marked as in the callback
+      unsigned long held[N];
+      for(uint8_t i=0; i<N; i++)
+        held[i] = now - elapsedMils[i];
+      inCallback |= fire;
+      for(uint8_t i=0; fire && i<N; i++)
       {
-        bp.inCallback=true;
-        uint8_t oldSREG = SREG; // Save the status
-        interrupts();
-        callback(now - elapsedMils);
-        SREG = oldSREG;
-        bp.inCallback=false;
+        PBportMask m = pinMask[i];
+        if(!(fire & m))
+          continue;
+        fire &= ~m;
+        PBirq irq = PBenable(); // Save the status, the interrupts on
+        callback[i](held[i]);
+        PBrestore(irq);
+        inCallback &= ~m;
       }
     }
 
     // if not used you can comment out this functions 
-    bool type() const { return LOW; }
+    bool type() const { return ACTIVE; }
+    uint8_t size() const { return N; }
     bool isMonitoring() const { return bp.monitoring; } // is monitored = ISR installed
     void setUBdelay(unsigned long t) { debounceDelay = t; }
     unsigned long getUBdelay(void) const { return debounceDelay; }
-    bool isInCallback() const { return bp.inCallback; }
-    void setCallback(PBcallback f) { callback=f; }
-    PBcallback getCallback() const { return callback; }
+    bool isInCallback(uint8_t i) const { return (inCallback & pinMask[i]) != 0; }
+    bool isPressed(uint8_t i) const { return ((snapshot & pinMask[i]) != 0) == ACTIVE; } // last state seen by the ISR
+    void setCallback(uint8_t i, PBcallback f) { callback[i] = f; }
+    PBcallback getCallback(uint8_t i) const { return callback[i]; }
 
   private:
-    uint8_t pinPB; // pinPB at which change of level is monitored
-    PBcallback callback; // pointer to function to be called when button is pressed
-    ISR isr; // pointer to void f() function to serve as interrupt service routine - must be defined on a global scope
-    unsigned long elapsedMils; // elapsed millis since the last call to ISR
-    unsigned long debounceDelay; // time to be ignorred - changes that appear @ t < debounceDelay will be ignored
-    struct bitPack // saves space packing all bool data memebers in single bute
+    uint8_t pinPB[N]; // pins at which change of level is monitored
+    PBportMask pinMask[N]; // bit of each of the pins in the port input register
+    PBcallback callback[N]; // functions to be called when the buttons are pressed
+    unsigned long elapsedMils[N]; // time each of the buttons was pushed down
+    ISR isr; // pointer to void f() function to serve as interrupt service routine for all the pins - must be defined on a global scope
+    unsigned long debounceDelay; // time to be ignorred - presses shorter than debounceDelay will be ignored
+    PBportReg *pinReg; // input register of the port all the pins belong to
+    PBportMask usedMask; // bits of the port used by the bank
+    volatile PBportMask snapshot; // state of the port at the previous interrupt
+    volatile PBportMask inCallback; // bits of the buttons whose callbacks are executing
+    struct bitPack
     {
       uint8_t actWhen:1; // when to react (call the callbak) on press (true) or on release (false)
-      uint8_t inCallback:1; // true while executing the callback function, will not re-enter the function from the same interrupt (isr disabled)
-      uint8_t prevState:1; // previous state of the pinPB (checked in the ISR)
-      uint8_t monitoring:1; // is active and monitoring the push button
+      uint8_t monitoring:1; // is active and monitoring the push buttons
     } bp;
 };
 
-template <>
-class PBmonitor<HIGH> // the class specialization for a active high push button (connects pinPB to Vcc)
+// Bit sliced (vertical) 2 bit counters - debounce all the bits of a word in parallel with a fixed number of operations
+// A bit of the debounced state toggles only after the sample has differed from it on 4 consecutive updates,
+// any sample equal to the state resets the counter of that bit
+template <typename T>
+struct PBvcounter
+{
+  T state; // debounced state
+  T cnt0, cnt1; // low and high bits of the counters
+  PBvcounter() : state(0), cnt0(0), cnt1(0) { }
+  T update(T sample) // returns the bits of the state that toggled
+  {
+    T delta = sample ^ state;
+    cnt1 = (cnt1 ^ cnt0) & delta;
+    cnt0 = ~cnt0 & delta;
+    T toggle = delta & ~(cnt0 | cnt1);
+    state ^= toggle;
+    return toggle;
+  }
+  bool settled() const { return !(cnt0 | cnt1); } // no bit is counting
+};
+
+// Polled push buttons - up to 8 buttons per port on up to PORTS ports, sampled by calling tick() periodically 
+// (every 1-2ms, usually from a timer interrupt), instead of interrupts on every (bouncing) edge.
+// Each tick reads every used port once and debounces all the buttons on it in parallel with vertical counters,
+// so it costs the same regardless of how much the contacts bounce. A button is registered as pushed / released 
+// after 4 consecutive equal samples. The callbacks are called from poll() (in loop) with the same PBcallback 
+// semantics as PBmonitor: on press (0 is passed) or on release (the time the button was held down is passed)
+template <uint8_t N, bool ACTIVE = LOW, uint8_t PORTS = (N + 7) / 8>
+class PBmonitorPolled
 {
+  static_assert(N > 0 && PORTS > 0 && N <= PORTS * sizeof(PBportMask) * 8, "too many buttons for the ports");
   public:
-    PBmonitor(uint8_t pinPBNo, PBcallback f, ISR isrv, bool actpr = ONRELEASE, unsigned long t_i = 20) : 
-      pinPB(pinPBNo), callback(f), isr(isrv), debounceDelay(t_i), elapsedMils(0)
+    PBmonitorPolled(const uint8_t *pinPBNo, const PBcallback *f, uint8_t tickMs = 1, bool actpr = ONRELEASE) : 
+      ticks(0), period(tickMs), nPorts(0)
     { 
+      for(uint8_t i=0; i<N; i++)
+      {
+        pinPB[i] = pinPBNo[i];
+        callback[i] = f[i];
+        pinMask[i] = 0;
+        portIdx[i] = 0;
+        elapsedTicks[i] = 0;
+        heldTicks[i] = 0;
+      }
+      for(uint8_t p=0; p<PORTS; p++)
+      {
+        pinReg[p] = 0;
+        usedMask[p] = 0;
+        down[p] = up[p] = 0;
+      }
       bp.actWhen = actpr;
-      bp.inCallback = false;
-      bp.prevState = HIGH;
       bp.monitoring = false;
     }
-    ~PBmonitor() { stopMonitoring(); }
-    void startMonitoring() 
+
+    // returns false (and does not start) if the pins are spread on more than PORTS ports
+    bool startMonitoring() 
     { 
-      digitalWrite(pinPB, LOW); 
-      pinMode(pinPB, INPUT); // pulldown resistor needed
-      bp.prevState = digitalRead(pinPB);
-      elapsedMils=0;
-      bp.monitoring=true;
-      uint8_t oldSREG = SREG; // Save the status
-      noInterrupts();
-      // attachInterrupt(digitalPinToInterrupt(pinPB), isr, CHANGE); // set interrupt on change
-      enableInterrupt( pinPB, isr, CHANGE);
-      SREG = oldSREG;
+      uint8_t port[PORTS] = { };
+      uint8_t n = 0; // ports found (counted locally, nPorts is set once they fit)
+      for(uint8_t i=0; i<N; i++)
+      {
+        uint8_t pt = digitalPinToPort(pinPB[i]), p = 0;
+        while(p < n && port[p] != pt)
+          p++;
+        if(p == n)
+        {
+          if(n == PORTS)
+            return false;
+          port[n++] = pt;
+        }
+        portIdx[i] = p;
+      }
+      nPorts = n;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      for(uint8_t p=0; p<n; p++)
+      {
+        pinReg[p] = portInputRegister(port[p]);
+        usedMask[p] = 0;
+        vc[p] = PBvcounter<PBportMask>();
+        down[p] = up[p] = 0;
+      }
+      for(uint8_t i=0; i<N; i++)
+      {
+        digitalWrite(pinPB[i], ACTIVE ? LOW : HIGH); 
+        pinMode(pinPB[i], ACTIVE ? INPUT : INPUT_PULLUP); // pulldown resistor needed for active high buttons
+        pinMask[i] = digitalPinToBitMask(pinPB[i]);
+        usedMask[portIdx[i]] |= pinMask[i];
+      }
+      bp.monitoring = true;
+      PBrestore(irq);
+      return true;
     }
 
-    void stopMonitoring() 
+    void stopMonitoring() { bp.monitoring = false; }
+
+    // to be called every tickMs milliseconds (usually from a timer interrupt)
+    void tick() 
     { 
-      // detachInterrupt(digitalPinToInterrupt(pinPB)); 
-      disableInterrupt(pinPB);
-      bp.monitoring=false; 
+      if(!bp.monitoring)
+        return;
+      ticks++;
+      for(uint8_t p=0; p<nPorts; p++)
+      {
+        PBportMask sample = (ACTIVE ? *pinReg[p] : ~*pinReg[p]) & usedMask[p]; // 1 = pushed
+        PBportMask toggle = vc[p].update(sample);
+        if(toggle) // a button has (finally) changed - only once per press / release, not on every bounce
+          stamp(p, toggle);
+      }
     }
 
-    void change() 
+    // runs the callbacks of the buttons pressed / released since the last call, call it from loop()
+    void poll()
+    {
+      for(uint8_t p=0; p<nPorts; p++)
+      {
+        PBirq irq = PBdisable(); // Save the status, the interrupts off
+        PBportMask d = down[p], u = up[p];
+        down[p] = up[p] = 0;
+        PBrestore(irq);
+        PBportMask fire = bp.actWhen ? d : u;
+        for(uint8_t i=0; fire && i<N; i++)
+          if(portIdx[i] == p && (fire & pinMask[i]))
+          {
+            fire &= ~pinMask[i];
+            callback[i](bp.actWhen ? 0 : getHeld(i));
+          }
+      }
+    }
+
+    // if not used you can comment out this functions 
+    bool type() const { return ACTIVE; }
+    uint8_t size() const { return N; }
+    bool isMonitoring() const { return bp.monitoring; }
+    bool isPressed(uint8_t i) const { return (vc[portIdx[i]].state & pinMask[i]) != 0; } // debounced state
+    unsigned long heldFor(uint8_t i) const // how long the button has been held down (0 if released) in ms
     { 
-      bool pushRegistered=false;
-      uint8_t oldSREG = SREG; // Save the status
-      interrupts();
-      unsigned long now=millis();
-      SREG = oldSREG;
-      bool state = digitalRead(pinPB);
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      unsigned long t = isPressed(i) ? (ticks - elapsedTicks[i]) * period : 0;
+      PBrestore(irq);
+      return t; 
+    }
+    unsigned long getUBdelay(void) const { return 4UL * period; } // time a level must be stable to be registered
+    void setCallback(uint8_t i, PBcallback f) { callback[i] = f; }
+    PBcallback getCallback(uint8_t i) const { return callback[i]; }
+
+  private:
+    void stamp(uint8_t p, PBportMask toggle) // records the time of the press / release of the buttons that toggled
+    {
+      PBportMask pressed = vc[p].state;
+      down[p] |= toggle & pressed;
+      up[p] |= toggle & ~pressed;
+      for(uint8_t i=0; i<N; i++)
+        if(portIdx[i] == p && (toggle & pinMask[i]))
+        {
+          if(pressed & pinMask[i])
+            elapsedTicks[i] = ticks;
+          else
+            heldTicks[i] = ticks - elapsedTicks[i];
+        }
+    }
+    unsigned long getHeld(uint8_t i) const
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      unsigned long t = heldTicks[i] * period;
+      PBrestore(irq);
+      return t;
+    }
+
+    uint8_t pinPB[N]; // pins of the buttons
+    PBportMask pinMask[N]; // bit of each of the pins in its port input register
+    uint8_t portIdx[N]; // index of the port (in pinReg) of each of the pins
+    PBcallback callback[N]; // functions to be called when the buttons are pressed
+    volatile unsigned long elapsedTicks[N]; // tick at which each of the buttons was pushed down
+    volatile unsigned long heldTicks[N]; // duration of the last press of each button in ticks
+    PBportReg *pinReg[PORTS]; // input registers of the used ports
+    PBportMask usedMask[PORTS]; // bits of the ports used by the buttons
+    PBvcounter<PBportMask> vc[PORTS]; // debounced state (1 = pushed) and counters of each port
+    volatile PBportMask down[PORTS], up[PORTS]; // buttons pushed / released not yet reported by poll()
+    volatile unsigned long ticks; // number of tick() calls
+    uint8_t period; // tick period in ms
+    uint8_t nPorts; // number of ports used
+    struct bitPack
+    {
+      uint8_t actWhen:1; // when to react (call the callbak) on press (true) or on release (false)
+      uint8_t monitoring:1; // is active and sampling the push buttons
+    } bp;
+};
+
+// pointer to void function to be called on a key of a PBmatrix, passing the key number (row * COLS + column)
+// and, as with PBcallback, 0 on press or the time the key was held down in ms on release
+typedef void (*PBkeyCallback) (uint8_t, unsigned long);
+
+// Key matrix - ROWS x COLS keys, the columns on up to PORTS ports, the rows on any pins. While idle all the rows are
+// driven LOW and a FALLING interrupt is enabled on the columns (with pullups), so nothing runs while no key is touched.
+// The first edge disables the column interrupts and starts the scanning: poll() (from loop) drives one row at a time,
+// reads the columns a port at a time and debounces all the keys of the row in parallel with vertical counters
+// (registered after 4 equal scans, scanMs apart), so any number of keys can be held down at once (n-key rollover - 
+// a diode in series with each key is needed against ghosting). Once no key is down and all have settled it goes back
+// to waiting for the interrupt. The held time is kept in 16 bits (up to 65s).
+template <uint8_t ROWS, uint8_t COLS, uint8_t PORTS = 1>
+class PBmatrix
+{
+  static_assert(ROWS > 0 && COLS > 0 && ROWS * COLS <= 256 && COLS <= PORTS * sizeof(PBportMask) * 8, "bad matrix size");
+  public:
+    PBmatrix(const uint8_t *rowPins, const uint8_t *colPins, PBkeyCallback f, ISR isrv, bool actpr = ONRELEASE, uint8_t scanMs = 2) : 
+      callback(f), isr(isrv), period(scanMs)
+    {
+      init(rowPins, colPins, actpr);
+    }
+#if PB_REGISTRY_SIZE > 0
+    // the columns served by the shared ISR of PBregistry (takes COLS entries of it)
+    PBmatrix(const uint8_t *rowPins, const uint8_t *colPins, PBkeyCallback f, bool actpr = ONRELEASE, uint8_t scanMs = 2) : 
+      callback(f), isr(0), period(scanMs)
+    {
+      init(rowPins, colPins, actpr);
+    }
+#endif
+    ~PBmatrix() { stopMonitoring(); }
+
+    // returns false (and does not start) if the columns are spread on more than PORTS ports or the registry is full
+    bool startMonitoring()
+    {
+      uint8_t port[PORTS] = { };
+      uint8_t n = 0; // ports found (counted locally, nPorts is set once they fit)
+      for(uint8_t c=0; c<COLS; c++)
+      {
+        uint8_t pt = digitalPinToPort(colPin[c]), p = 0;
+        while(p < n && port[p] != pt)
+          p++;
+        if(p == n)
+        {
+          if(n == PORTS)
+            return false;
+          port[n++] = pt;
+        }
+        portIdx[c] = p;
+      }
+      nPorts = n;
+      for(uint8_t c=0; c<COLS; c++)
+        if(!isr && !PBregistry::add(colPin[c], this, PBregistry::changeOf<PBmatrix>, PBregistry::idleOf<PBmatrix>))
+        {
+          while(c--)
+            PBregistry::remove(colPin[c]);
+          return false;
+        }
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      for(uint8_t p=0; p<n; p++)
+      {
+        pinReg[p] = portInputRegister(port[p]);
+        usedMask[p] = 0;
+      }
+      for(uint8_t c=0; c<COLS; c++)
+      {
+        digitalWrite(colPin[c], HIGH);
+        pinMode(colPin[c], INPUT_PULLUP);
+        colMask[c] = digitalPinToBitMask(colPin[c]);
+        usedMask[portIdx[c]] |= colMask[c];
+      }
+      for(uint8_t r=0; r<ROWS; r++)
+      {
+        digitalWrite(rowPin[r], LOW);
+        for(uint8_t p=0; p<PORTS; p++)
+          vc[r][p] = PBvcounter<PBportMask>();
+      }
+      bp.monitoring = true;
+      scanning = true; // a first scan, then idle if nothing is pushed
+      lastScan = millis() - period;
+      PBrestore(irq);
+      return true;
+    }
 
-      // only this part actually differs in the specialization ...
-      if(bp.prevState == HIGH && state == LOW)
-        pushRegistered = !bp.actWhen;
-      else if(bp.prevState == LOW && state == HIGH) // released - take action now
+    void stopMonitoring()
+    {
+      if(!bp.monitoring)
+        return;
+      for(uint8_t c=0; c<COLS; c++)
       {
-        elapsedMils = now; // just store the time when pushed down
-        pushRegistered = bp.actWhen;
+        PBdetach(colPin[c]);
+        if(!isr)
+          PBregistry::remove(colPin[c]);
       }
-      // differ ends
+      for(uint8_t r=0; r<ROWS; r++)
+        pinMode(rowPin[r], INPUT);
+      bp.monitoring = false;
+      scanning = false;
+    }
 
-      bp.prevState=state;
-      if(pushRegistered && (bp.actWhen || now - elapsedMils > debounceDelay) && !bp.inCallback) // was pressed long enought and not servicing previous press
+    void change() // the ISR of the columns - a key was touched, start scanning
+    {
+      if(scanning)
+        return;
+      for(uint8_t c=0; c<COLS; c++)
+        PBdetach(colPin[c]);
+      scanning = true;
+      lastScan = millis() - period; // scan at once
+    }
+
+    // scans the matrix (every scanMs) and runs the callbacks of the keys pressed / released, call it from loop()
+    // returns at once while idle (waiting for the interrupt)
+    void poll()
+    {
+      if(!scanning)
+        return;
+      unsigned long now = millis();
+      if(now - lastScan < period)
+        return;
+      lastScan = now;
+      bool busy = false;
+      for(uint8_t r=0; r<ROWS; r++)
+        pinMode(rowPin[r], INPUT); // all rows released (high impedance) ...
+      for(uint8_t r=0; r<ROWS; r++)
       {
-        bp.inCallback=true;
-        uint8_t oldSREG = SREG; // Save the status
-        interrupts();
-        callback(now - elapsedMils);
-        SREG = oldSREG;
-        bp.inCallback=false;
+        pinMode(rowPin[r], OUTPUT); // ... but the one scanned, driven LOW
+        PBportMask sample[PORTS] = { };
+        for(uint8_t p=0; p<nPorts; p++)
+          sample[p] = ~*pinReg[p] & usedMask[p]; // 1 = pushed
+        pinMode(rowPin[r], INPUT);
+        for(uint8_t p=0; p<nPorts; p++)
+        {
+          PBportMask toggle = vc[r][p].update(sample[p]);
+          if(toggle) // a key has (finally) changed - only once per press / release, not on every bounce
+            report(r, p, toggle, now);
+          busy |= vc[r][p].state || !vc[r][p].settled();
+        }
       }
+      for(uint8_t r=0; r<ROWS; r++)
+        pinMode(rowPin[r], OUTPUT); // idle - all rows driven LOW
+      if(!busy)
+        sleep();
     }
 
-    // if not used you can comment out tis functions 
-    bool type() const { return HIGH; }
-    bool isMonitoring() const { return bp.monitoring; } // is monitored = ISR installed
-    void setUBdelay(unsigned long t) { debounceDelay = t; }
-    unsigned long getUBdelay(void) const { return debounceDelay; }
-    bool isInCallback() const { return bp.inCallback; }
-    void setCallback(PBcallback f) { callback=f; }
-    PBcallback getCallback() const { return callback; }
+    // if not used you can comment out this functions 
+    uint8_t size() const { return ROWS * COLS; }
+    bool isMonitoring() const { return bp.monitoring; }
+    bool isScanning() const { return scanning; } // false while waiting for the interrupt
+    bool isIdle() const { return !scanning; }
+    bool isPressed(uint8_t key) const // debounced state
+    {
+      uint8_t c = key % COLS;
+      return (vc[key / COLS][portIdx[c]].state & colMask[c]) != 0;
+    }
+    unsigned long getUBdelay(void) const { return 4UL * period; } // time a level must be stable to be registered
+    void setCallback(PBkeyCallback f) { callback = f; }
+    PBkeyCallback getCallback() const { return callback; }
 
-  protected:
-    uint8_t pinPB; // pinPB at which change of level is monitored
-    PBcallback callback; // pointer to function to be called when button is pressed
-    ISR isr; // pointer to void f() function to serve as interrupt service routine - must be defined on a global scope
-    unsigned long elapsedMils; // elapsed millis since the last call to ISR
-    unsigned long debounceDelay; // time to be ignorred - changes that appear @ t < debounceDelay will be ignored
-    struct bitPack // saves space packing all bool data memebers in single bute
+  private:
+    void init(const uint8_t *rowPins, const uint8_t *colPins, bool actpr)
+    {
+      for(uint8_t r=0; r<ROWS; r++)
+        rowPin[r] = rowPins[r];
+      for(uint8_t c=0; c<COLS; c++)
+      {
+        colPin[c] = colPins[c];
+        colMask[c] = 0;
+        portIdx[c] = 0;
+      }
+      for(uint16_t k=0; k<ROWS * COLS; k++)
+        pushedAt[k] = 0;
+      nPorts = 0;
+      lastScan = 0;
+      scanning = false;
+      bp.actWhen = actpr;
+      bp.monitoring = false;
+    }
+
+    void report(uint8_t r, uint8_t p, PBportMask toggle, unsigned long now) // calls back the keys of row r that toggled
+    {
+      PBportMask pressed = vc[r][p].state;
+      for(uint8_t c=0; c<COLS; c++)
+        if(portIdx[c] == p && (toggle & colMask[c]))
+        {
+          uint8_t key = r * COLS + c;
+          if(pressed & colMask[c])
+          {
+            pushedAt[key] = now;
+            if(bp.actWhen)
+              callback(key, 0);
+          }
+          else if(!bp.actWhen)
+            callback(key, (uint16_t)((uint16_t)now - pushedAt[key]));
+        }
+    }
+
+    void sleep() // back to waiting for a key to be touched
+    {
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      scanning = false;
+      bool low = false;
+      for(uint8_t c=0; c<COLS; c++)
+      {
+        PBattach(colPin[c], isr ? isr : PBregistry::isrOf(colPin[c]), FALLING);
+        low |= !(*pinReg[portIdx[c]] & colMask[c]);
+      }
+      if(low) // touched meanwhile (no edge will come)
+        change();
+      PBrestore(irq);
+    }
+
+    uint8_t rowPin[ROWS]; // pins of the rows
+    uint8_t colPin[COLS]; // pins of the columns
+    PBportMask colMask[COLS]; // bit of each of the columns in its port input register
+    uint8_t portIdx[COLS]; // index of the port (in pinReg) of each of the columns
+    PBportReg *pinReg[PORTS]; // input registers of the ports used by the columns
+    PBportMask usedMask[PORTS]; // bits of the ports used by the columns
+    PBvcounter<PBportMask> vc[ROWS][PORTS]; // debounced state (1 = pushed) and counters of each row
+    uint16_t pushedAt[ROWS * COLS]; // millis() (low 16 bits) when each key was pushed down
+    PBkeyCallback callback; // function to be called when a key is pressed
+    ISR isr; // the ISR of the columns (0 - the shared ISR of PBregistry)
+    unsigned long lastScan; // millis() of the last scan
+    volatile bool scanning; // a key is touched - scanning (false - waiting for the interrupt)
+    uint8_t period; // scan period in ms
+    uint8_t nPorts; // number of ports used by the columns
+    struct bitPack
     {
       uint8_t actWhen:1; // when to react (call the callbak) on press (true) or on release (false)
-      uint8_t inCallback:1; // true while executing the callback function, will not re-enter the function from the same interrupt (isr disabled)
-      uint8_t prevState:1; // previous state of the pinPB (checked in the ISR)
-      uint8_t monitoring:1; // is active and monitoring the push button
+      uint8_t monitoring:1; // is active
+    } bp;
+};
+
+// Resistor ladder - N buttons on a single analog pin, each pulling it to a different level. The readings are mapped
+// to the buttons by a table of thresholds (half way between the levels, sorted, searched by bisection) computed once
+// from the nominal readings of the buttons and of the idle pin (none pushed). A button is registered after stable
+// equal readings in a row, then its PBcallback is called as by PBmonitor (from the interrupt, with the interrupts
+// enabled): on press (0 is passed) or on release (the time the button was held down is passed). Only one button at a
+// time is recognized (pushing two gives a level of its own - it can be added to the table as another "button").
+// sample() takes the readings - on AVR from the ADC running free with PB_LADDER_ON_ADC (the ADC is then not
+// available to analogRead()), elsewhere call it with analogRead() periodically.
+template <uint8_t N>
+class PBladder
+{
+  public:
+    PBladder(uint8_t pinNo, const uint16_t *levels, const PBcallback *f, uint16_t idleLevel = 1023, uint8_t stableCount = 4, bool actpr = ONRELEASE) : 
+      pin(pinNo), stable(stableCount), current(NONE), candidate(NONE), count(0), pressedAt(0)
+    {
+      for(uint8_t i=0; i<N; i++)
+        callback[i] = f[i];
+      uint16_t lvl[N + 1]; // the levels sorted, with their buttons
+      for(uint8_t i=0; i<=N; i++)
+      {
+        uint16_t v = i < N ? levels[i] : idleLevel;
+        uint8_t j = i;
+        for( ; j > 0 && lvl[j - 1] > v; j--)
+        {
+          lvl[j] = lvl[j - 1];
+          key[j] = key[j - 1];
+        }
+        lvl[j] = v;
+        key[j] = i < N ? i : (uint8_t)NONE;
+      }
+      for(uint8_t i=0; i<N; i++)
+        upper[i] = (lvl[i] + lvl[i + 1]) / 2;
+      bp.actWhen = actpr;
+      bp.inCallback = false;
+      bp.monitoring = false;
+    }
+    ~PBladder() { stopMonitoring(); }
+
+    void startMonitoring()
+    {
+      current = candidate = NONE;
+      count = 0;
+#if defined(__AVR__) && defined(ADCSRA)
+      uint8_t ch = pin >= A0 ? pin - A0 : pin;
+      PBirq irq = PBdisable(); // Save the status, the interrupts off
+      ADMUX = _BV(REFS0) | (ch & 0x07); // AVcc reference
+#if defined(MUX5)
+      ADCSRB = ch & 0x08 ? _BV(MUX5) : 0; // free running
+#else
+      ADCSRB = 0; // free running
+#endif
+      ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0); // 125kHz @ 16MHz
+      PBrestore(irq);
+#else
+      pinMode(pin, INPUT);
+#endif
+      bp.monitoring = true;
+    }
+
+    void stopMonitoring()
+    {
+#if defined(__AVR__) && defined(ADCSRA)
+      ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+#endif
+      bp.monitoring = false;
+    }
+
+    void sample(uint16_t v) // a reading of the pin (the ADC interrupt)
+    {
+      if(!bp.monitoring || bp.inCallback)
+        return;
+      uint8_t k = classify(v);
+      if(k != candidate)
+      {
+        candidate = k;
+        count = 0;
+      }
+      if(k == current || ++count < stable) // not changed, or not stable long enough
+        return;
+      uint8_t was = current;
+      current = k;
+      unsigned long now = millis();
+      if(was != NONE && !bp.actWhen) // released
+        invoke(was, now - pressedAt);
+      if(k != NONE)
+      {
+        pressedAt = now;
+        if(bp.actWhen)
+          invoke(k, 0);
+      }
+    }
+
+    // if not used you can comment out this functions 
+    uint8_t size() const { return N; }
+    bool isMonitoring() const { return bp.monitoring; }
+    uint8_t pressed() const { return current; } // the button pushed (0..N-1), N if none
+    uint8_t classify(uint16_t v) const // the button the reading belongs to (N if none)
+    {
+      uint8_t lo = 0, hi = N; // the first level with v below its upper threshold
+      while(lo < hi)
+      {
+        uint8_t mid = (lo + hi) >> 1;
+        if(v < upper[mid])
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+      return key[lo];
+    }
+    void setCallback(uint8_t i, PBcallback f) { callback[i] = f; }
+    PBcallback getCallback(uint8_t i) const { return callback[i]; }
+
+  private:
+    enum { NONE = N };
+    void invoke(uint8_t k, unsigned long n)
+    {
+      bp.inCallback = true;
+      PBirq irq = PBenable(); // Save the status, the interrupts on
+      callback[k](n);
+      PBrestore(irq);
+      bp.inCallback = false;
+    }
+
+    uint8_t pin; // the analog pin
+    uint8_t stable; // equal readings in a row to register a change
+    PBcallback callback[N]; // functions to be called when the buttons are pressed
+    uint16_t upper[N]; // thresholds between the sorted levels
+    uint8_t key[N + 1]; // the button of each of the sorted levels (NONE - idle)
+    volatile uint8_t current; // the button registered as pushed (NONE - none)
+    uint8_t candidate; // the button of the last readings
+    uint8_t count; // equal readings in a row
+    unsigned long pressedAt; // millis() when the current button was pushed
+    struct bitPack
+    {
+      uint8_t actWhen:1; // when to react (call the callbak) on press (true) or on release (false)
+      uint8_t inCallback:1; // executing a callback - the readings are ignored
+      uint8_t monitoring:1; // is active
     } bp;
 };
 
+#if defined(__AVR__) && defined(TIMSK0)
+// Ticks a PBmonitorPolled object from the Timer0 compare A interrupt, Timer0 already runs millis() and its period is
+// not changed - so it ticks every 1.024ms at 16MHz (the times held are reported 2.4% short with tickMs = 1).
+// OCR0A is also the PWM of pin 6 (OC0A on Uno / Nano): do not use analogWrite() on pin 6 with it, PBenableTimer0Tick()
+// sets OCR0A and analogWrite() would move the tick.
+// Use at global scope: PB_POLL_ON_TIMER0(buttons); and call PBenableTimer0Tick() in setup()
+#define PB_POLL_ON_TIMER0(PBPOLLED) ISR(TIMER0_COMPA_vect) { PBPOLLED.tick(); }
+inline void PBenableTimer0Tick() { OCR0A = 0x80; TIMSK0 |= _BV(OCIE0A); }
+#endif
+
+#if defined(__AVR__) && defined(ADCSRA)
+// Feeds a PBladder from the free running ADC, every 16th conversion (~600 readings/s with the 125kHz ADC clock).
+// Use at global scope: PB_LADDER_ON_ADC(ladder); the ADC is started by startMonitoring()
+#define PB_LADDER_ON_ADC(PBLADDER) ISR(ADC_vect) { static uint8_t n; if(!(++n & 15)) PBLADDER.sample(ADC); }
+#endif
+
+#if defined(__AVR__) && defined(WDT_vect)
+// Keeps millis() going while PBpower sleeps in power down, use at global scope: PB_POWER_ON_WDT;
+// and set the period in setup(): PBpower::setWatchdog(WDTO_1S);
+#define PB_POWER_ON_WDT ISR(WDT_vect) { PBpower::tick(); }
+#endif
+
 #endif //idPushButton_H__
 
@@ -0,0 +1,83 @@
+/*
+  idPushButton scheduler example - long LED sequences started from the button callbacks without delay()
+  The callbacks only start a task in PBscheduler and return at once, the sequences run step by step from loop(),
+  so the buttons stay responsive (and the other button can start its sequence) while a sequence is running.
+  Pushing a button again while its sequence is running restarts the sequence.
+
+  The example circuit:
+   * LEDs on pins 5 and 6 to ground (+ resistors)
+   * switch (normally open) from pin 3 to GND (internal pull-up configured)
+   * switch (normally open) from pin 2 to Vcc with a 10K pull-down resistor
+
+ created 16.10.2026
+ */
+
+#include <idPushButton.h>
+
+#define LED_R 6
+#define LED_G 5
+
+#define PB1 3
+#define PB2 2
+
+PBscheduler<4> scheduler;
+
+// the FlashLeds sequence of idPBMonitor_example1 as a step function: G on, R on, G off, R off - three times
+unsigned long FlashStep(void *ctx, uint8_t &step)
+{
+  const unsigned int t = 100;
+  switch(step++ & 3)
+  {
+    case 0: digitalWrite(LED_G, HIGH); return t;
+    case 1: digitalWrite(LED_R, HIGH); return t;
+    case 2: digitalWrite(LED_G, LOW); return t;
+  }
+  digitalWrite(LED_R, LOW);
+  return step < 12 ? 3 * t : PB_TASK_DONE;
+}
+
+// blinks the LED given as context n times, n being the seconds the button was held down (at least once)
+struct Blink
+{
+  uint8_t led;
+  uint8_t times;
+};
+Blink blinkR = { LED_R, 1 };
+
+unsigned long BlinkStep(void *ctx, uint8_t &step)
+{
+  Blink *b = (Blink *)ctx;
+  digitalWrite(b->led, !(step & 1)); // on at even steps
+  step++;
+  return step < 2 * b->times ? 250 : PB_TASK_DONE;
+}
+
+void FlashLeds(unsigned long n)
+{
+  scheduler.start(FlashStep);
+}
+
+void BlinkLeds(unsigned long n)
+{
+  blinkR.times = n / 1000 + 1;
+  scheduler.start(BlinkStep, &blinkR);
+}
+
+PUSH_BUTTON_L(button1, PB1, FlashLeds, ONRELEASE);
+PUSH_BUTTON_H(button2, PB2, BlinkLeds, ONRELEASE);
+
+void setup()
+{
+  Serial.begin(115200);
+  pinMode(LED_G, OUTPUT);
+  pinMode(LED_R, OUTPUT);
+  button1.startMonitoring();
+  button2.startMonitoring();
+  Serial.println("Push buttons ready ...");
+}
+
+void loop()
+{
+  scheduler.run(); // runs the steps that are due
+  // any other (non blocking) work
+}
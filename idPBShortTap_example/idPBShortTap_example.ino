@@ -0,0 +1,44 @@
+/*
+  idPushButton short tap example - times the presses in microseconds (PB_TIMEBASE_MICROS)
+  A tap shorter than 150ms toggles the LED, a longer press turns it off. Every press is printed with the time it
+  was held to the microsecond (4us resolution with micros() on a 16MHz AVR), as the button stores only the low
+  16 bits of micros() when pushed down and extends them with millis() when the time held is reported.
+
+  The example circuit:
+   * LED on pin 6 to ground (+ resistor)
+   * switch (normally open) from pin 3 to GND (internal pull-up configured)
+
+ created 16.10.2026
+ */
+
+#define PB_TIMEBASE PB_TIMEBASE_MICROS // the callbacks get the time held in us
+#define PB_REGISTRY_SIZE 1 // the button served by the shared ISR
+#include <idPushButton.h>
+
+#define LED 6
+#define PB1 3
+
+#define TAP_US 150000UL
+
+void Pressed(unsigned long us)
+{
+  digitalWrite(LED, us < TAP_US ? !digitalRead(LED) : LOW);
+  Serial.print(us < TAP_US ? "tap " : "press ");
+  Serial.print(us);
+  Serial.println("us");
+}
+
+PBmonitor<LOW> button1(PB1, Pressed, ONRELEASE, 10); // served by the shared ISR, 10ms debounce (up to 65ms with micros())
+
+void setup()
+{
+  Serial.begin(115200);
+  pinMode(LED, OUTPUT);
+  button1.startMonitoring();
+  Serial.println("Tap the button ...");
+}
+
+void loop()
+{
+  // EVERYTHING is interrupt driven
+}
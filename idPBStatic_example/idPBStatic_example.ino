@@ -0,0 +1,71 @@
+/*
+  idPushButton compile time configured buttons example - PBmonitorStatic and the size report
+  The same three buttons as in idPBMonitor_example1, but with pin, type, edge and debounce time given as template
+  parameters. No ISR wrappers are needed and nothing is stored per object.
+  Prints the RAM used per button by both variants. For the flash used, compile the sketch with
+  USE_STATIC set to 1 and to 0 and compare the program storage space reported by the IDE.
+
+  The example circuit:
+   * LEDs on pins 5 and 6 to ground (+ resistors)
+   * switch (normally open) from pin 3 to GND (internal pull-up configured)
+   * switch (normally open) from pin 2 to Vcc with a 10K pull-down resistor
+   * switch (normally open) from pin 7 to GND (internal pull-up configured)
+
+ created 16.10.2026
+ */
+
+#define USE_STATIC 1
+
+#include <idPushButton.h>
+
+#define LED_R 6
+#define LED_G 5
+
+#define PB1 3
+#define PB2 2
+#define PB3 7
+
+void Toggle(uint8_t led) { pinMode(led, OUTPUT); digitalWrite(led, !digitalRead(led)); }
+void ToggleG(unsigned long n) { Toggle(LED_G); }
+void ToggleR(unsigned long n) { Toggle(LED_R); }
+void ToggleBoth(unsigned long n) { Toggle(LED_G); Toggle(LED_R); }
+
+#if USE_STATIC
+PBmonitorStatic<PB2, LOW, ONRELEASE, 20> button1(ToggleG);
+PBmonitorStatic<PB1, HIGH, ONPRESS> button2(ToggleR);
+PBmonitorStatic<PB3, LOW, ONPRESS> button3(ToggleBoth);
+#else
+PUSH_BUTTON_L(button1, PB2, ToggleG, ONRELEASE);
+PUSH_BUTTON_H(button2, PB1, ToggleR, ONPRESS);
+PUSH_BUTTON_L(button3, PB3, ToggleBoth, ONPRESS);
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(100);
+
+  button1.startMonitoring();
+  button2.startMonitoring();
+  button3.startMonitoring();
+
+  Serial.println(USE_STATIC ? "PBmonitorStatic" : "PBmonitor");
+  Serial.print("sizeof(PBmonitor<LOW>)=");
+  Serial.println(sizeof(PBmonitor<LOW>));
+  Serial.print("sizeof(PBmonitor<HIGH>)=");
+  Serial.println(sizeof(PBmonitor<HIGH>));
+  Serial.print("sizeof(PBmonitorStatic<..., ONRELEASE>)=");
+  Serial.print(sizeof(PBmonitorStatic<PB2, LOW, ONRELEASE, 20>));
+  Serial.print(" + static ");
+  Serial.println(PBmonitorStatic<PB2, LOW, ONRELEASE, 20>::staticSize());
+  Serial.print("sizeof(PBmonitorStatic<..., ONPRESS>)=");
+  Serial.print(sizeof(PBmonitorStatic<PB1, HIGH, ONPRESS>));
+  Serial.print(" + static ");
+  Serial.println(PBmonitorStatic<PB1, HIGH, ONPRESS>::staticSize());
+  Serial.println();
+}
+
+void loop()
+{
+  // EVERYTHING is interrupt driven
+}
@@ -0,0 +1,437 @@
+/*
+  FILE:     idPBhost.h
+  PURPOSE:  Host (Linux/PC) simulation of the Arduino API used by idPushButton.h
+  LICENCE:  GPL v3 (http://www.gnu.org/licenses/gpl.html)
+
+  Compile with -DPB_HOST and idPushButton.h will include this file instead of Arduino.h and EnableInterrupt.h,
+  so the push button logic can be run, tested and benchmarked on a PC without a board.
+  Everything is header only and meant to be included in a single translation unit (the host program).
+
+  Provides:
+  - a virtual clock in microseconds driving millis(), micros() and delay()
+  - virtual pins grouped in 8 bit ports (pinMode, digitalRead, digitalWrite, portInputRegister, ...)
+  - a simulated interrupt controller (enableInterrupt / disableInterrupt, the I flag in SREG,
+    interrupts() / noInterrupts(), nested interrupts once an ISR re-enables them)
+  - with PB_ATOMIC a multicore Cortex-M core instead of the AVR - no SREG and no EnableInterrupt library, but
+    attachInterrupt() / detachInterrupt() and the PRIMASK of CMSIS, one per thread (every thread is a core)
+  - optionally a time every ISR takes (pbSim::state().isrTime), so the edges coming while it runs wait and
+    coalesce as on the hardware (0 - the ISRs run at the very moment of the edge)
+  - a time ordered queue of scheduled pin edges, played back by pbSim::run() / delay()
+  - a deterministic bounce waveform generator (pbSim::press) with configurable bounce count, jitter and hold time
+  - the sleep modes and the watchdog of avr/sleep.h and avr/wdt.h - sleep_cpu() advances the virtual clock to the
+    interrupt waking the MCU (the next edge, the millis() timer in idle, the watchdog in power down) and sums the time
+    slept in pbSim::state().sleptDeep / sleptIdle
+  - a hook (pbSim::state().circuit) to model circuitry reacting to the outputs, e.g. a key matrix
+  - Print and a Serial writing to the standard output
+ */
+
+#ifndef idPBhost_H__
+#define idPBhost_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define LOW  0
+#define HIGH 1
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+#define WDTO_15MS 0 // watchdog periods (avr/wdt.h), for PBpower::setWatchdog()
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#ifndef PB_SIM_PORTS
+#define PB_SIM_PORTS 4 // number of simulated 8 bit ports (up to 8)
+#endif
+#define NUM_DIGITAL_PINS (PB_SIM_PORTS * 8)
+#ifndef PB_SIM_EDGES
+#define PB_SIM_EDGES 1024 // capacity of the queue of scheduled edges
+#endif
+
+#if !PB_ATOMIC
+static volatile uint8_t arduinoInterruptedPin = 0; // as set by the EnableInterrupt library (EI_ARDUINO_INTERRUPTED_PIN)
+#endif
+
+namespace pbSim
+{
+  typedef void (*Handler)();
+
+  struct Edge // a scheduled change of level of a pin
+  {
+    unsigned long long t; // virtual time in microseconds
+    uint8_t pin;
+    uint8_t level;
+  };
+
+  struct State
+  {
+    unsigned long long now; // virtual time in microseconds
+    volatile uint32_t port[PB_SIM_PORTS]; // port input registers (only the low 8 bits are used)
+    uint8_t mode[NUM_DIGITAL_PINS]; // pinMode of each pin
+    Handler handler[NUM_DIGITAL_PINS]; // ISR attached to each pin
+    uint8_t intMode[NUM_DIGITAL_PINS]; // CHANGE, RISING or FALLING
+    uint64_t pending; // interrupt requests not yet serviced (one bit per pin)
+    uint64_t driven; // pins driven by the external circuitry (a pullup does not change their level)
+    Handler circuit; // called after every pinMode() / digitalWrite() - models circuitry reacting to outputs (e.g. a key matrix)
+    unsigned long isrTime; // time each ISR takes in microseconds (0 - no time, run at once)
+    unsigned long long busy; // with isrTime - the time the running ISR ends
+    unsigned long long sleptDeep, sleptIdle; // time slept by PBpower in power down / idle mode
+    unsigned long wakeups; // number of PBpower sleeps
+    uint8_t sleepMode, sleepEnabled; // set_sleep_mode(), sleep_enable()
+    uint8_t wdtcsr, mcusr; // the watchdog registers (only WDIE and the period are used)
+    uint8_t sreg; // only the I flag (bit 7) is used (with PB_ATOMIC the one of each thread - see iflag())
+    unsigned long isrCalls; // number of ISRs executed
+    unsigned long edges; // number of edges played back
+    Edge queue[PB_SIM_EDGES]; // scheduled edges sorted by time
+    unsigned int queued;
+  };
+
+  inline State &state() { static State s; return s; }
+
+  // the I flag (bit 7) of the running core
+#if PB_ATOMIC
+  inline uint8_t &iflag() { static thread_local uint8_t f = 0x80; return f; }
+#else
+  inline uint8_t &iflag() { return state().sreg; }
+#endif
+
+  // runs the pending ISRs while interrupts are enabled, as the hardware would
+  // (with isrTime only one, when no other is running - run() serves the rest as the time goes)
+  inline void dispatch()
+  {
+    State &s = state();
+    if(s.isrTime && s.now < s.busy)
+      return;
+    while((iflag() & 0x80) && s.pending)
+    {
+      uint8_t pin = __builtin_ctzll(s.pending); // lowest pin has the highest priority
+      s.pending &= ~(1ULL << pin);
+      if(!s.handler[pin])
+        continue;
+      uint8_t saved = iflag();
+      iflag() &= ~0x80; // interrupts disabled on ISR entry
+      s.isrCalls++;
+#if !PB_ATOMIC
+      arduinoInterruptedPin = pin;
+#endif
+      s.handler[pin]();
+      iflag() = saved; // and enabled again by reti
+      if(s.isrTime)
+      {
+        s.busy = s.now + s.isrTime;
+        break;
+      }
+    }
+  }
+
+  inline bool level(uint8_t pin) { return (state().port[pin >> 3] >> (pin & 7)) & 1; }
+
+  // changes the level of a pin, raising an interrupt request if enabled
+  inline void setLevel(uint8_t pin, bool lvl)
+  {
+    State &s = state();
+    bool old = level(pin);
+    if(old == lvl)
+      return;
+    if(lvl)
+      s.port[pin >> 3] |= 1UL << (pin & 7);
+    else
+      s.port[pin >> 3] &= ~(1UL << (pin & 7));
+    if(s.handler[pin] && (s.intMode[pin] == CHANGE || (s.intMode[pin] == RISING) == lvl))
+    {
+      s.pending |= 1ULL << pin;
+      if(!s.isrTime)
+        dispatch();
+    }
+  }
+
+  // sets the level of a pin as the external circuitry would (e.g. a button)
+  inline void setPin(uint8_t pin, bool lvl)
+  {
+    state().driven |= 1ULL << pin;
+    setLevel(pin, lvl);
+  }
+
+  // schedules an edge at virtual time t (in microseconds), returns false if the queue is full
+  inline bool schedule(unsigned long long t, uint8_t pin, bool lvl)
+  {
+    State &s = state();
+    if(s.queued >= PB_SIM_EDGES)
+      return false;
+    unsigned int i = s.queued++;
+    for( ; i > 0 && s.queue[i - 1].t > t; i--) // keep sorted, same time edges stay in the order scheduled
+      s.queue[i] = s.queue[i - 1];
+    s.queue[i].t = t;
+    s.queue[i].pin = pin;
+    s.queue[i].level = lvl;
+    return true;
+  }
+
+  // advances the virtual clock to time t playing back all the edges scheduled until then
+  // (and with isrTime serving the interrupts requested as the running ISRs end)
+  inline void run(unsigned long long t)
+  {
+    State &s = state();
+    for(;;)
+    {
+      unsigned long long next = s.queued ? s.queue[0].t : ~0ULL;
+      if(s.isrTime && s.pending && (iflag() & 0x80))
+      {
+        unsigned long long svc = s.busy > s.now ? s.busy : s.now; // when the CPU is free to serve it
+        if(svc <= next && svc <= t)
+        {
+          s.now = svc;
+          dispatch();
+          continue;
+        }
+      }
+      if(next > t)
+        break;
+      Edge e = s.queue[0];
+      s.queued--;
+      for(unsigned int i = 0; i < s.queued; i++)
+        s.queue[i] = s.queue[i + 1];
+      if(e.t > s.now)
+        s.now = e.t;
+      s.edges++;
+      setPin(e.pin, e.level);
+    }
+    if(t > s.now)
+      s.now = t;
+  }
+
+  inline void advance(unsigned long long us) { run(state().now + us); }
+  inline unsigned long long now() { return state().now; }
+  inline unsigned long long next() { return state().queued ? state().queue[0].t : ~0ULL; } // time of the next scheduled edge
+
+  // resets the simulation: time 0, all pins LOW, no ISRs, interrupts enabled
+  inline void reset()
+  {
+    State &s = state();
+    s = State();
+    iflag() = 0x80;
+  }
+
+  // small deterministic pseudo random generator (xorshift32), so the waveforms are repeatable
+  class Rng
+  {
+    public:
+      Rng(uint32_t seed = 1) : x(seed ? seed : 1) { }
+      uint32_t next() { x ^= x << 13; x ^= x >> 17; x ^= x << 5; return x; }
+      uint32_t uniform(uint32_t lo, uint32_t hi) { return hi > lo ? lo + next() % (hi - lo + 1) : lo; } // in [lo, hi]
+    private:
+      uint32_t x;
+  };
+
+  struct Bounce // shape of a bouncing contact
+  {
+    uint8_t bounces; // number of extra pulses (chatter) after the first edge on make and on break
+    unsigned long jitter; // maximal time between two bounce edges (random 1..jitter microseconds)
+    unsigned long hold; // time from the first make edge to the first break edge in microseconds
+  };
+
+  // schedules a complete press of a button on pin starting at time t: a bouncing make, hold, a bouncing break
+  // active is the level of the pin while pushed, returns the time the pin settles released
+  inline unsigned long long press(uint8_t pin, bool active, unsigned long long t, const Bounce &b, Rng &rng)
+  {
+    unsigned long long e = t;
+    for(uint8_t phase = 0; phase < 2; phase++) // make, then break
+    {
+      bool lvl = phase ? !active : active;
+      schedule(e, pin, lvl);
+      for(uint8_t i = 0; i < b.bounces; i++)
+      {
+        e += rng.uniform(1, b.jitter);
+        schedule(e, pin, !lvl);
+        e += rng.uniform(1, b.jitter);
+        schedule(e, pin, lvl);
+      }
+      if(!phase)
+        e = t + b.hold > e ? t + b.hold : e + 1;
+    }
+    return e;
+  }
+}
+
+#if !PB_ATOMIC
+// the SREG register - restoring it with the I flag set runs the interrupts requested meanwhile
+class PBsimSREG
+{
+  public:
+    operator uint8_t() const { return pbSim::iflag(); }
+    PBsimSREG &operator=(uint8_t v)
+    {
+      pbSim::iflag() = v;
+      if(v & 0x80)
+        pbSim::dispatch();
+      return *this;
+    }
+};
+static PBsimSREG SREG;
+#else
+// CMSIS - PRIMASK set masks the interrupts, clearing it runs the interrupts requested meanwhile
+#define __CORTEX_M 0
+inline uint32_t __get_PRIMASK() { return !(pbSim::iflag() & 0x80); }
+inline void __set_PRIMASK(uint32_t m)
+{
+  pbSim::iflag() = m & 1 ? 0 : 0x80;
+  if(!(m & 1))
+    pbSim::dispatch();
+}
+inline void __disable_irq() { __set_PRIMASK(1); }
+inline void __enable_irq() { __set_PRIMASK(0); }
+#endif
+
+inline void interrupts() { pbSim::iflag() |= 0x80; pbSim::dispatch(); }
+inline void noInterrupts() { pbSim::iflag() &= ~0x80; }
+
+// avr/sleep.h and avr/wdt.h
+#define SLEEP_MODE_IDLE     0
+#define SLEEP_MODE_PWR_DOWN 2
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+#define WDP3 5
+#define WDCE 4
+#define WDE  3
+#define WDIE 6
+#define WDRF 3
+#define WDTCSR (pbSim::state().wdtcsr)
+#define MCUSR (pbSim::state().mcusr)
+inline void wdt_reset() { }
+inline void set_sleep_mode(uint8_t mode) { pbSim::state().sleepMode = mode; }
+inline void sleep_enable() { pbSim::state().sleepEnabled = 1; }
+inline void sleep_disable() { pbSim::state().sleepEnabled = 0; }
+// sleeps until an interrupt: the next edge wakes it, in idle mode also the timer (millis) interrupt, in power down
+// the watchdog (if its interrupt is enabled) - a sleep nothing would ever wake from returns at once
+inline void sleep_cpu()
+{
+  pbSim::State &s = pbSim::state();
+  if(!s.sleepEnabled)
+    return;
+  unsigned long long t = pbSim::next();
+  if(s.sleepMode == SLEEP_MODE_IDLE && (s.now / 1000 + 1) * 1000 < t)
+    t = (s.now / 1000 + 1) * 1000;
+  else if(s.sleepMode == SLEEP_MODE_PWR_DOWN && (s.wdtcsr & _BV(WDIE)))
+  {
+    uint8_t period = (s.wdtcsr & 7) | (s.wdtcsr & _BV(WDP3) ? 8 : 0);
+    if(s.now + (16000ULL << period) < t)
+      t = s.now + (16000ULL << period);
+  }
+  if(t == ~0ULL)
+    return;
+  (s.sleepMode == SLEEP_MODE_PWR_DOWN ? s.sleptDeep : s.sleptIdle) += t - s.now;
+  s.wakeups++;
+  pbSim::run(t);
+}
+
+inline unsigned long micros() { return (unsigned long)pbSim::state().now; }
+inline unsigned long millis() { return (unsigned long)(pbSim::state().now / 1000); }
+inline void delay(unsigned long ms) { pbSim::advance(ms * 1000ULL); }
+inline void delayMicroseconds(unsigned int us) { pbSim::advance(us); }
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  pbSim::state().mode[pin] = mode;
+  if(mode == INPUT_PULLUP && !(pbSim::state().driven & (1ULL << pin)))
+    pbSim::setLevel(pin, HIGH);
+  if(pbSim::state().circuit)
+    pbSim::state().circuit();
+}
+inline void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if(pbSim::state().mode[pin] == OUTPUT)
+    pbSim::setPin(pin, val);
+  if(pbSim::state().circuit)
+    pbSim::state().circuit();
+}
+inline int digitalRead(uint8_t pin) { return pbSim::level(pin); }
+
+inline uint8_t digitalPinToPort(uint8_t pin) { return pin >> 3; }
+inline uint32_t digitalPinToBitMask(uint8_t pin) { return 1UL << (pin & 7); }
+inline volatile uint32_t *portInputRegister(uint8_t port) { return &pbSim::state().port[port]; }
+
+// minimal Print (the numbers and strings printing part), Serial writes to the standard output
+class Print
+{
+  public:
+    virtual ~Print() { }
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t n) { size_t i = 0; while(i < n && write(buf[i])) i++; return i; }
+    size_t print(const char *str) { size_t n = 0; while(*str) n += write((uint8_t)*str++); return n; }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned long n, int base = DEC)
+    {
+      char buf[8 * sizeof(long) + 1], *p = buf + sizeof(buf) - 1;
+      *p = 0;
+      do { unsigned long d = n % base; *--p = d < 10 ? '0' + d : 'A' + d - 10; n /= base; } while(n);
+      return print(p);
+    }
+    size_t print(long n, int base = DEC) { return n < 0 && base == DEC ? print('-') + print((unsigned long)-n, base) : print((unsigned long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(double d, int digits = 2) { char buf[32]; snprintf(buf, sizeof(buf), "%.*f", digits, d); return print(buf); }
+    size_t println() { return print("\r\n"); }
+    template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <class T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+};
+
+class PBsimSerial : public Print
+{
+  public:
+    void begin(unsigned long) { }
+    operator bool() const { return true; }
+    size_t write(uint8_t c) { return putchar(c) == EOF ? 0 : 1; }
+    using Print::write;
+    void flush() { fflush(stdout); }
+};
+static PBsimSerial Serial;
+
+#if !PB_ATOMIC
+// the EnableInterrupt library API
+inline void enableInterrupt(uint8_t pin, pbSim::Handler f, uint8_t mode)
+{
+  pbSim::state().handler[pin] = f;
+  pbSim::state().intMode[pin] = mode;
+}
+inline void disableInterrupt(uint8_t pin)
+{
+  pbSim::state().handler[pin] = 0;
+  pbSim::state().pending &= ~(1ULL << pin);
+}
+#else
+// attachInterrupt() of the core - every pin has its own interrupt
+#define NOT_AN_INTERRUPT -1
+inline int digitalPinToInterrupt(uint8_t pin) { return pin < NUM_DIGITAL_PINS ? pin : NOT_AN_INTERRUPT; }
+inline void attachInterrupt(int irq, pbSim::Handler f, int mode)
+{
+  if(irq < 0 || irq >= NUM_DIGITAL_PINS)
+    return;
+  pbSim::state().handler[irq] = f;
+  pbSim::state().intMode[irq] = mode;
+}
+inline void detachInterrupt(int irq)
+{
+  if(irq < 0 || irq >= NUM_DIGITAL_PINS)
+    return;
+  pbSim::state().handler[irq] = 0;
+  pbSim::state().pending &= ~(1ULL << irq);
+}
+#endif
+
+#endif //idPBhost_H__